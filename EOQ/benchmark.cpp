@@ -0,0 +1,420 @@
+/**
+ * @file     benchmark.cpp
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Benchmark of the Q* solver (eoq.h). It times every reference
+ *           of references.h at D = 10, 1e3, 1e5 and 1e7, and synthetic
+ *           references with 1 to 1000 tiers, and writes one CSV row per
+ *           case with ns/solve, solves/s and the peak RSS so far, so
+ *           that runs can be compared with each other.
+ *
+ *           With --layout it compares instead the layouts of a big
+ *           catalog: the reference_t of catalog.h (a heap block per list
+ *           of tiers) and the flat one of flat.h, solving rows in catalog
+ *           order and in random order. It writes ns/solve, the cache
+ *           lines read per reference and, where the kernel allows it,
+ *           the cache misses per solve.
+ *
+ *           Build: g++ -O2 benchmark.cpp -o benchmark
+ *           Usage: ./benchmark [seconds per case] > results.csv
+ *                  ./benchmark --layout [references] > layout.csv
+ */
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "references.h"
+#include "eoq.h"
+#include "catalog.h"
+#include "flat.h"
+
+#include <chrono>
+#include <linux/perf_event.h>
+#include <random>
+#include <set>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+//-----[ CONSTANTS ]----------------------------------------------------------//
+
+// Seconds that each case is repeated for (can be changed in argv[1])
+#define DEFAULT_SECONDS 0.2
+
+// References of the catalog of --layout (can be changed in argv[2])
+#define LAYOUT_REFERENCES 200000
+
+// Rows solved in each case of --layout
+#define LAYOUT_ROWS 2000000
+
+// Bytes of a cache line
+#define CACHE_LINE 64
+
+//-----[ GLOBALS ]------------------------------------------------------------//
+
+// Sum of every Q* found, printed at the end so no solve can be optimised out
+static long long checksum = 0;
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that gets the peak resident set size of the process.
+ * @param  void
+ * @return Peak RSS in KiB.
+ */
+static long peakRSS(void)
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_maxrss;
+
+}   /* peakRSS() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that builds a reference with the given number of ca
+ *         and ce tiers: prices of ca go down and prices of ce go up
+ *         every 'step' units, like the real tables of references.h.
+ * @param  tiers  Number of tiers of each list.
+ * @param  step  Units between two breakpoints.
+ * @return Synthetic reference.
+ */
+static reference_t syntheticReference(int tiers, int step)
+{
+    reference_t item = {};
+
+    item.id = "synthetic-" + to_string(tiers);
+    item.description = "Referencia sintética";
+    item.cp_percentage = 0.15;
+
+    for (int j = 0; j < tiers; j++)
+    {
+        item.ca_list.push_back({ 1 + j * step, 0.60f - 0.40f * j / tiers });
+        item.ce_list.push_back({ 1 + j * step, 3.95f + 0.25f * j });
+    }
+
+    return item;
+
+}   /* syntheticReference() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that times the solver for one reference and one demand
+ *         and prints the CSV row of the case.
+ * @param  item  Reference to solve.
+ * @param  D  Annual demand.
+ * @param  seconds  Minimum time to repeat the solve for.
+ * @return void
+ */
+static void benchmarkCase(const reference_t * item, int D, double seconds)
+{
+    tiers_t tiers = tiersOf(item);
+    long long iterations = 0;
+    long long batch = 1;
+    chrono::duration<double> elapsed(0.0);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    // Double the number of solves between clock reads until time is up
+    while (elapsed.count() < seconds)
+    {
+        for (long long i = 0; i < batch; i++)
+        {
+            checksum += solveOptimalQ(D, &tiers).Q;
+        }
+
+        iterations += batch;
+        batch *= 2;
+        elapsed = chrono::steady_clock::now() - start;
+    }
+
+    double ns = elapsed.count() * 1e9 / iterations;
+
+    printf("%s,%d,%d,%lld,%.1f,%.0f,%ld\n", item->id.c_str(),
+           (int)(item->ca_list.size() + item->ce_list.size()), D,
+           iterations, ns, 1e9 / ns, peakRSS());
+
+}   /* benchmarkCase() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that opens a counter of the cache misses of this
+ *         process (user space only).
+ * @param  void
+ * @return File descriptor of the counter, or -1 if it is not available.
+ */
+static int openMissCounter(void)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+
+}   /* openMissCounter() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that adds the cache lines of a block of memory to a set.
+ * @param  lines  Set of cache lines.
+ * @param  data  Start of the block.
+ * @param  size  Bytes of the block.
+ * @return void
+ */
+static void addLines(set<uintptr_t> * lines, const void * data, size_t size)
+{
+    uintptr_t first = (uintptr_t)data / CACHE_LINE;
+    uintptr_t last = ((uintptr_t)data + size - 1) / CACHE_LINE;
+
+    for (uintptr_t line = first; line <= last; line++)
+    {
+        lines->insert(line);
+    }
+
+}   /* addLines() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that counts the cache lines that the solver reads to
+ *         get the tiers of every reference, on average, in each layout.
+ * @param  catalog  Catalog of references.
+ * @param  flat  Flat layout of the same catalog.
+ * @param  nested  Where the lines per reference of catalog_t are stored.
+ * @param  flattened  Where the lines per reference of flat.h are stored.
+ * @return void
+ */
+static void countLines(const catalog_t * catalog, const flat_catalog_t * flat,
+                       double * nested, double * flattened)
+{
+    size_t total[2] = { 0, 0 };
+
+    for (size_t i = 0; i < (catalog->references).size(); i++)
+    {
+        const reference_t & item = catalog->references[i];
+        const flat_record_t & record = flat->records[i];
+        set<uintptr_t> lines[2];
+
+        addLines(&lines[0], &(item.ca_list), sizeof(item.ca_list));
+        addLines(&lines[0], &(item.ce_list), sizeof(item.ce_list));
+        addLines(&lines[0], &(item.cp_percentage), sizeof(float));
+        addLines(&lines[0], item.ca_list.data(),
+                 item.ca_list.size() * sizeof(cost_t));
+        addLines(&lines[0], item.ce_list.data(),
+                 item.ce_list.size() * sizeof(cost_t));
+
+        addLines(&lines[1], &record, sizeof(record));
+        addLines(&lines[1], &(flat->pool[record.ca_offset]),
+                 (record.ca_count + record.ce_count) * sizeof(cost_t));
+
+        total[0] += lines[0].size();
+        total[1] += lines[1].size();
+    }
+
+    *nested = (double)total[0] / (catalog->references).size();
+    *flattened = (double)total[1] / (catalog->references).size();
+
+}   /* countLines() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that solves rows of a catalog in one layout and prints
+ *         the CSV row of the case.
+ * @param  layout  Name of the layout.
+ * @param  access  Name of the order of the rows.
+ * @param  rows  Position of the reference and demand of every row.
+ * @param  tiersAt  Gets the tiers of a position in the layout.
+ * @param  lines  Cache lines read per reference in the layout.
+ * @return void
+ */
+template <typename F>
+static void layoutCase(const char * layout, const char * access,
+                       const vector<pair<uint32_t, int>> & rows, F tiersAt,
+                       double lines)
+{
+    int counter = openMissCounter();
+    long long misses = 0;
+
+    if (counter >= 0)
+    {
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    for (const pair<uint32_t, int> & row : rows)
+    {
+        tiers_t tiers = tiersAt(row.first);
+
+        checksum += solveOptimalQ(row.second, &tiers).Q;
+    }
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    double ns = elapsed.count() * 1e9 / rows.size();
+
+    printf("%s,%s,%zu,%.1f,%.0f,%.2f,", layout, access, rows.size(), ns,
+           1e9 / ns, lines);
+
+    if ((counter >= 0) &&
+        (read(counter, &misses, sizeof(misses)) == sizeof(misses)))
+    {
+        printf("%.3f\n", (double)misses / rows.size());
+    }
+    else
+    {
+        printf("n/a\n");
+    }
+
+    if (counter >= 0)
+    {
+        close(counter);
+    }
+
+}   /* layoutCase() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that compares the two layouts of a synthetic catalog
+ *         built like loadCatalog() builds one: the tiers of each of its
+ *         references are copied from a random reference of references.h
+ *         with its breakpoints scaled.
+ * @param  count  Number of references of the catalog.
+ * @return void
+ */
+static void benchmarkLayout(size_t count)
+{
+    catalog_t catalog;
+    flat_catalog_t flat;
+    mt19937 random(12345);
+    string error;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        reference_t item = *R_ALL[random() % R_ALL_COUNT];
+        int scale = 1 + random() % 8;
+
+        item.id = "REF" + to_string(i);
+
+        for (size_t t = 1; t < item.ca_list.size(); t++)
+        {
+            item.ca_list[t].min_unit *= scale;
+        }
+
+        for (size_t t = 1; t < item.ce_list.size(); t++)
+        {
+            item.ce_list[t].min_unit *= scale;
+        }
+
+        addReference(&catalog, item, &error);
+    }
+
+    buildFlatCatalog(&catalog, &flat);
+
+    vector<pair<uint32_t, int>> sequential(LAYOUT_ROWS);
+    vector<pair<uint32_t, int>> shuffled(LAYOUT_ROWS);
+
+    for (size_t r = 0; r < LAYOUT_ROWS; r++)
+    {
+        int D = 1 + random() % 100000;
+
+        sequential[r] = make_pair((uint32_t)(r % count), D);
+        shuffled[r] = make_pair((uint32_t)(random() % count), D);
+    }
+
+    double lines[2];
+
+    countLines(&catalog, &flat, &lines[0], &lines[1]);
+
+    auto nested = [&](uint32_t i)
+    {
+        return tiersOf(&(catalog.references[i]));
+    };
+
+    auto flattened = [&](uint32_t i)
+    {
+        return flatTiers(&flat, i);
+    };
+
+    printf("layout,access,rows,ns_per_solve,solves_per_second,");
+    printf("lines_per_reference,cache_misses_per_solve\n");
+
+    for (int repeat = 0; repeat < 2; repeat++)
+    {
+        layoutCase("reference_t", "catalog", sequential, nested, lines[0]);
+        layoutCase("flat", "catalog", sequential, flattened, lines[1]);
+        layoutCase("reference_t", "random", shuffled, nested, lines[0]);
+        layoutCase("flat", "random", shuffled, flattened, lines[1]);
+    }
+
+}   /* benchmarkLayout() */
+
+/******************************************************************************/
+/*!
+ * @brief  Main program of the benchmark.
+ * @param  argc  Number of command line arguments.
+ * @param  argv  Seconds per case, or --layout and the number of
+ *               references (optional).
+ * @return 0
+ */
+int main(int argc, char * argv[])
+{
+    if ((argc > 1) && (strcmp(argv[1], "--layout") == 0))
+    {
+        long count = (argc > 2) ? atol(argv[2]) : LAYOUT_REFERENCES;
+
+        benchmarkLayout((count > 0) ? count : LAYOUT_REFERENCES);
+        fprintf(stderr, "checksum: %lld\n", checksum);
+
+        return 0;
+    }
+
+    const int demands[] = { 10, 1000, 100000, 10000000 };
+    const int synthetic[] = { 1, 10, 100, 1000 };
+    double seconds = (argc > 1) ? atof(argv[1]) : DEFAULT_SECONDS;
+
+    printf("reference,tiers,D,iterations,ns_per_solve,solves_per_second,");
+    printf("peak_rss_kb\n");
+
+    for (size_t i = 0; i < R_ALL_COUNT; i++)
+    {
+        for (int D : demands)
+        {
+            benchmarkCase(R_ALL[i], D, seconds);
+        }
+    }
+
+    for (int tiers : synthetic)
+    {
+        // Spread the breakpoints over [1, 2·D] of the largest demand
+        reference_t item = syntheticReference(tiers, 20000000 / tiers);
+
+        for (int D : demands)
+        {
+            benchmarkCase(&item, D, seconds);
+        }
+    }
+
+    fprintf(stderr, "checksum: %lld\n", checksum);
+
+    return 0;
+
+}   /* main() */
+
+/*** end of file ***/
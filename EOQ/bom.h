@@ -0,0 +1,441 @@
+/**
+ * @file     bom.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Bill of materials: the components (and their quantities) that
+ *           every product needs, on as many levels as wanted, to turn the
+ *           demand of the finished products into the Annual Demand of
+ *           each component.
+ *
+ *           The file has one line per component of a product, with three
+ *           fields separated by ';', ',' or tabs:
+ *
+ *             product;component;quantity
+ *
+ *           where quantity is the units of component per unit of product,
+ *           as a decimal number or a fraction. A component may be a
+ *           product of other lines (a subassembly). Empty lines and lines
+ *           that start with '#' are ignored. For the 1 kg jar:
+ *
+ *             tarro-1kg;NVLS745;1
+ *             tarro-1kg;110212;1
+ *             tarro-1kg;303117;1/12
+ *
+ *           The lines are kept as a sparse matrix by rows (CSR): the
+ *           components of each node are contiguous. The demand is
+ *           expanded in topological order (every product before its
+ *           components), so each node pushes its total demand down once,
+ *           and the whole expansion is one pass over the lines.
+ */
+
+#ifndef BOM_H
+#define BOM_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+//-----[ CONSTANTS ]----------------------------------------------------------//
+
+// Relative rounding error of an expanded demand (a few ulps per level)
+#define BOM_TOLERANCE 1e-12
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef struct
+{
+    uint32_t component;     // Node of the component
+    double quantity;        // Units of it per unit of the product
+
+} bom_edge_t;
+
+typedef struct
+{
+    vector<string> names;                   // ID of every node
+    unordered_map<string, size_t> index;    // ID -> node
+    vector<size_t> first;                   // Components of node n are
+    vector<bom_edge_t> edges;               // edges[first[n], first[n + 1])
+    vector<uint32_t> order;                 // Products before components
+
+} bom_t;
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that finds the node of an ID, adding it if it is new.
+ * @param  bom  Bill of materials.
+ * @param  id  ID of the product or component.
+ * @return Node of the ID.
+ */
+inline uint32_t bomNode(bom_t * bom, const string & id)
+{
+    auto inserted = bom->index.emplace(id, bom->names.size());
+
+    if (inserted.second)
+    {
+        bom->names.push_back(id);
+    }
+
+    return (uint32_t)inserted.first->second;
+
+}   /* bomNode() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that reads the quantity of a line: a positive decimal
+ *         number or a fraction "a/b".
+ * @param  begin  First character of the quantity.
+ * @param  end  One past its last character.
+ * @param  quantity  Where the quantity is stored.
+ * @return false if it is not a positive number.
+ */
+inline bool parseBomQuantity(const char * begin, const char * end,
+                             double * quantity)
+{
+    string text(begin, end);
+    char * stop;
+    double value = strtod(text.c_str(), &stop);
+
+    if (stop == text.c_str())
+    {
+        return false;
+    }
+
+    if (*stop == '/')
+    {
+        const char * denominator = stop + 1;
+        double divisor = strtod(denominator, &stop);
+
+        if ((stop == denominator) || (divisor <= 0.0))
+        {
+            return false;
+        }
+
+        value /= divisor;
+    }
+
+    while (*stop == ' ')
+    {
+        stop++;
+    }
+
+    *quantity = value;
+
+    return (*stop == '\0') && (value > 0.0) && (value < 1e12);
+
+}   /* parseBomQuantity() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that reads one line of a BOM file.
+ * @param  begin  First character of the line.
+ * @param  end  One past its last character (without the '\n').
+ * @param  product  Where the ID of the product is stored.
+ * @param  component  Where the ID of the component is stored.
+ * @param  quantity  Where the units per unit of product are stored.
+ * @return false if the line does not have the three fields.
+ */
+inline bool parseBomLine(const char * begin, const char * end,
+                         string * product, string * component,
+                         double * quantity)
+{
+    const char * field[4] = { begin, NULL, NULL, end + 1 };
+
+    for (int f = 1; f < 3; f++)
+    {
+        const char * p = field[f - 1];
+
+        while ((p < end) && (strchr(",;\t", *p) == NULL))
+        {
+            p++;
+        }
+
+        if (p == end)
+        {
+            return false;
+        }
+
+        field[f] = p + 1;
+    }
+
+    // Trim the blanks around both IDs
+    string * id[2] = { product, component };
+
+    for (int f = 0; f < 2; f++)
+    {
+        const char * a = field[f];
+        const char * b = field[f + 1] - 1;
+
+        while ((a < b) && (*a == ' '))
+        {
+            a++;
+        }
+
+        while ((b > a) && (b[-1] == ' '))
+        {
+            b--;
+        }
+
+        if (a == b)
+        {
+            return false;
+        }
+
+        id[f]->assign(a, b);
+    }
+
+    return parseBomQuantity(field[2], end, quantity);
+
+}   /* parseBomLine() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that sorts the nodes in topological order (Kahn), so
+ *         that every product comes before its components.
+ * @param  bom  Bill of materials, with its edges already by rows.
+ * @param  error  Where the reason is stored if there is a cycle.
+ * @return false if some product is (indirectly) a component of itself.
+ */
+inline bool sortBom(bom_t * bom, string * error)
+{
+    size_t n = bom->names.size();
+    vector<uint32_t> parents(n, 0);
+
+    for (const bom_edge_t & edge : bom->edges)
+    {
+        parents[edge.component]++;
+    }
+
+    bom->order.clear();
+    bom->order.reserve(n);
+
+    for (size_t node = 0; node < n; node++)
+    {
+        if (parents[node] == 0)
+        {
+            bom->order.push_back((uint32_t)node);
+        }
+    }
+
+    // The order grows while it is read: it is its own queue
+    for (size_t k = 0; k < bom->order.size(); k++)
+    {
+        uint32_t node = bom->order[k];
+
+        for (size_t e = bom->first[node]; e < bom->first[node + 1]; e++)
+        {
+            if (--parents[bom->edges[e].component] == 0)
+            {
+                bom->order.push_back(bom->edges[e].component);
+            }
+        }
+    }
+
+    if (bom->order.size() < n)
+    {
+        for (size_t node = 0; node < n; node++)
+        {
+            if (parents[node] > 0)
+            {
+                *error = "hay un ciclo en el que está '" + bom->names[node];
+                *error += "'";
+                break;
+            }
+        }
+        return false;
+    }
+
+    return true;
+
+}   /* sortBom() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that loads a BOM file (see the format at the top of this
+ *         file), stores its lines by rows and sorts its nodes.
+ * @param  path  Path of the BOM file.
+ * @param  bom  Where the bill of materials is stored.
+ * @param  error  Where the reason is stored if the file is not valid.
+ * @return true if every line was loaded and there are no cycles.
+ */
+inline bool loadBom(const char * path, bom_t * bom, string * error)
+{
+    FILE * file = fopen(path, "rb");
+
+    if (file == NULL)
+    {
+        *error = string("no se puede abrir el fichero '") + path + "'";
+        return false;
+    }
+
+    string text;
+    char block[1 << 16];
+    size_t n;
+
+    while ((n = fread(block, 1, sizeof(block), file)) > 0)
+    {
+        text.append(block, n);
+    }
+
+    fclose(file);
+
+    // Lines as (product, edge), to be sorted by product afterwards
+    vector<uint32_t> products;
+    vector<bom_edge_t> lines;
+    string product, component;
+    double quantity;
+    const char * p = text.c_str();
+    const char * stop = p + text.size();
+    int lineNumber = 0;
+
+    while (p < stop)
+    {
+        const char * end = (const char *)memchr(p, '\n', stop - p);
+
+        if (end == NULL)
+        {
+            end = stop;
+        }
+
+        const char * next = end + 1;
+        lineNumber++;
+
+        if ((end > p) && (end[-1] == '\r'))
+        {
+            end--;
+        }
+
+        if ((end > p) && (*p != '#'))
+        {
+            if (parseBomLine(p, end, &product, &component, &quantity) == false)
+            {
+                *error = "línea " + to_string(lineNumber) + ": se esperaba " +
+                         "'producto;componente;cantidad'";
+                return false;
+            }
+
+            products.push_back(bomNode(bom, product));
+            lines.push_back({ bomNode(bom, component), quantity });
+
+            if (products.back() == lines.back().component)
+            {
+                *error = "línea " + to_string(lineNumber) + ": '" + product +
+                         "' es componente de sí mismo";
+                return false;
+            }
+        }
+
+        p = next;
+    }
+
+    // Counting sort of the lines by product: the rows of the matrix
+    bom->first.assign(bom->names.size() + 1, 0);
+    bom->edges.resize(lines.size());
+
+    for (uint32_t node : products)
+    {
+        bom->first[node + 1]++;
+    }
+
+    for (size_t node = 0; node < bom->names.size(); node++)
+    {
+        bom->first[node + 1] += bom->first[node];
+    }
+
+    vector<size_t> next(bom->first.begin(), bom->first.end() - 1);
+
+    for (size_t k = 0; k < lines.size(); k++)
+    {
+        bom->edges[next[products[k]]++] = lines[k];
+    }
+
+    return sortBom(bom, error);
+
+}   /* loadBom() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that adds a node with no components (a reference that
+ *         only appears in the demands) at the end of the order.
+ * @param  bom  Bill of materials.
+ * @param  id  ID of the reference.
+ * @return Node of the ID.
+ */
+inline uint32_t addBomLeaf(bom_t * bom, const string & id)
+{
+    size_t count = bom->names.size();
+    uint32_t node = bomNode(bom, id);
+
+    if (bom->names.size() > count)
+    {
+        bom->first.push_back(bom->first.back());
+        bom->order.push_back(node);
+    }
+
+    return node;
+
+}   /* addBomLeaf() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that expands the demands of the products down to their
+ *         components: every node, in topological order, adds its total
+ *         demand times the quantity of each line to its components.
+ * @param  bom  Bill of materials.
+ * @param  demand  Demand of every node: the external one on input (of
+ *                 the products, or spare components), the total one on
+ *                 output.
+ * @return void
+ */
+inline void expandBom(const bom_t * bom, vector<double> * demand)
+{
+    double * d = demand->data();
+
+    for (uint32_t node : bom->order)
+    {
+        double units = d[node];
+
+        if (units == 0.0)
+        {
+            continue;
+        }
+
+        for (size_t e = bom->first[node]; e < bom->first[node + 1]; e++)
+        {
+            d[bom->edges[e].component] += units * bom->edges[e].quantity;
+        }
+    }
+
+}   /* expandBom() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that rounds an expanded demand up to whole units: 1/12
+ *         of a box for each jar still buys the box. The quantities are
+ *         not exact in binary (1/12, 0.1), so a demand that should be a
+ *         whole number may come out a few ulps above it; that error
+ *         grows with the demand, so it is taken off relative to it.
+ * @param  demand  Expanded demand of a node (from expandBom()).
+ * @return Whole units to order.
+ */
+inline double bomUnits(double demand)
+{
+    return ceil(demand - fabs(demand) * BOM_TOLERANCE);
+
+}   /* bomUnits() */
+
+#endif /* BOM_H */
+
+/*** end of file ***/
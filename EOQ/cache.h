@@ -0,0 +1,241 @@
+/**
+ * @file     cache.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Bounded cache of solutions in front of the solver, keyed by
+ *           reference ID, Annual Demand and the stamp of the catalog
+ *           (see catalogStamp()), so a change of prices never returns an
+ *           old result. It is split in shards with their own lock and
+ *           LRU list, so several threads can use it at the same time.
+ */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "eoq.h"
+#include "policy.h"
+
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+//-----[ CONSTANTS ]----------------------------------------------------------//
+
+// Most independent parts of the cache
+#define CACHE_SHARDS 16
+
+// Most buckets reserved up front for each shard (more grow with use)
+#define CACHE_RESERVE 4096
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef struct
+{
+    string id;
+    int D;
+    uint64_t stamp;
+
+} cache_key_t;
+
+typedef struct
+{
+    cache_key_t key;
+    solution_t solution;
+
+} cache_entry_t;
+
+struct cache_key_hash
+{
+    size_t operator()(const cache_key_t & key) const
+    {
+        size_t h = hash<string>()(key.id);
+
+        h ^= (size_t)key.D * 0x9E3779B97F4A7C15ull;
+        h ^= (size_t)key.stamp + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+
+        return h;
+    }
+};
+
+struct cache_key_equal
+{
+    bool operator()(const cache_key_t & a, const cache_key_t & b) const
+    {
+        return (a.D == b.D) && (a.stamp == b.stamp) && (a.id == b.id);
+    }
+};
+
+typedef struct
+{
+    mutex lock;
+    list<cache_entry_t> entries;    // Most recently used first
+    unordered_map<cache_key_t, list<cache_entry_t>::iterator,
+                  cache_key_hash, cache_key_equal> index;
+    size_t capacity;                // Entries this shard can keep
+    uint64_t hits;
+    uint64_t misses;
+
+} cache_shard_t;
+
+typedef struct
+{
+    int count;                      // Shards in use
+    cache_shard_t shards[CACHE_SHARDS];
+
+} result_cache_t;
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that empties the cache and sets its size. The capacity
+ *         is split exactly: the first capacity % shards shards keep one
+ *         more solution, and a cache of fewer than CACHE_SHARDS
+ *         solutions uses one shard per solution.
+ * @param  cache  Cache to initialise.
+ * @param  capacity  Maximum number of solutions kept in total (> 0).
+ * @return void
+ */
+inline void initCache(result_cache_t * cache, size_t capacity)
+{
+    cache->count = (int)min((size_t)CACHE_SHARDS, max((size_t)1, capacity));
+
+    for (int s = 0; s < CACHE_SHARDS; s++)
+    {
+        lock_guard<mutex> guard(cache->shards[s].lock);
+        size_t share = 0;
+
+        if (s < cache->count)
+        {
+            share = capacity / cache->count +
+                    ((size_t)s < capacity % cache->count);
+        }
+
+        cache->shards[s].capacity = share;
+        cache->shards[s].entries.clear();
+        cache->shards[s].index.clear();
+        cache->shards[s].index.reserve(min(share, (size_t)CACHE_RESERVE));
+        cache->shards[s].hits = 0;
+        cache->shards[s].misses = 0;
+    }
+
+}   /* initCache() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that solves a reference through the cache: a repeated
+ *         (ID, D, stamp) costs a hash lookup, and a new one is solved
+ *         and stored, dropping the least recently used solution of the
+ *         shard if it is full. The solver runs outside the lock.
+ * @param  cache  Cache of solutions.
+ * @param  id  ID of the reference.
+ * @param  D  Annual demand for the reference.
+ * @param  stamp  Stamp of the catalog the tiers come from.
+ * @param  tiers  Tiers of the reference.
+ * @return Costs of the optimal order.
+ */
+inline solution_t cachedSolve(result_cache_t * cache, const string & id,
+                              int D, uint64_t stamp, const tiers_t * tiers)
+{
+    cache_key_t key = { id, D, stamp };
+    cache_shard_t & shard = cache->shards[cache_key_hash()(key) %
+                                          cache->count];
+
+    {
+        lock_guard<mutex> guard(shard.lock);
+        auto searched = shard.index.find(key);
+
+        if (searched != shard.index.end())
+        {
+            // Move it to the front of the LRU list
+            shard.entries.splice(shard.entries.begin(), shard.entries,
+                                 searched->second);
+            shard.hits++;
+            return searched->second->solution;
+        }
+
+        shard.misses++;
+    }
+
+    solution_t solution = solveModelQ(D, tiers);
+    lock_guard<mutex> guard(shard.lock);
+
+    // Another thread may have stored it while this one was solving
+    if (shard.index.find(key) == shard.index.end())
+    {
+        shard.entries.push_front({ key, solution });
+        shard.index[key] = shard.entries.begin();
+
+        if (shard.entries.size() > shard.capacity)
+        {
+            shard.index.erase(shard.entries.back().key);
+            shard.entries.pop_back();
+        }
+    }
+
+    return solution;
+
+}   /* cachedSolve() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that adds up the counters of every shard.
+ * @param  cache  Cache of solutions.
+ * @param  hits  Where the number of hits is stored.
+ * @param  misses  Where the number of misses is stored.
+ * @param  entries  Where the number of stored solutions is stored.
+ * @return void
+ */
+inline void cacheStats(result_cache_t * cache, uint64_t * hits,
+                       uint64_t * misses, uint64_t * entries)
+{
+    *hits = 0;
+    *misses = 0;
+    *entries = 0;
+
+    for (int s = 0; s < CACHE_SHARDS; s++)
+    {
+        lock_guard<mutex> guard(cache->shards[s].lock);
+
+        *hits += cache->shards[s].hits;
+        *misses += cache->shards[s].misses;
+        *entries += cache->shards[s].entries.size();
+    }
+
+}   /* cacheStats() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that adds up the capacity of every shard, the one given
+ *         to initCache().
+ * @param  cache  Cache of solutions.
+ * @return Maximum number of solutions kept in total.
+ */
+inline size_t cacheCapacity(result_cache_t * cache)
+{
+    size_t capacity = 0;
+
+    for (int s = 0; s < CACHE_SHARDS; s++)
+    {
+        lock_guard<mutex> guard(cache->shards[s].lock);
+
+        capacity += cache->shards[s].capacity;
+    }
+
+    return capacity;
+
+}   /* cacheCapacity() */
+
+#endif /* CACHE_H */
+
+/*** end of file ***/
@@ -0,0 +1,577 @@
+/**
+ * @file     catalog.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Catalog of references loaded from a text file, with the
+ *           dictionary used to look them up by ID.
+ *
+ *           The file has one reference per line with five fields
+ *           separated by ';' (descriptions may contain commas):
+ *
+ *             id;description;ca_list;ce_list;cp_percentage
+ *
+ *           ca_list and ce_list are blank separated "min_unit:value"
+ *           tiers. The first tier of each list must start at 1 unit and
+ *           min_unit must be strictly increasing. Empty lines and lines
+ *           that start with '#' are ignored. See catalog.csv:
+ *
+ *             NVLS745;Envase de miel  1 kg liso V720;1:0.55 50:0.54;1:3.95;0.16
+ *
+ *           An optional sixth field sets the cost model of the reference
+ *           (see policy.h) with blank separated words; the ones that are
+ *           left out keep the original model:
+ *
+ *             incremental   Each unit at the ca of its own tier.
+ *             freight:V     A freight of V per unit, added to ce.
+ *             holding:H     A cp of H per unit and year, instead of
+ *                           cp_percentage of the price.
+ */
+
+#ifndef CATALOG_H
+#define CATALOG_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "types.h"
+
+#include <cmath>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef struct
+{
+    vector<reference_t> references;         // In file order, as in the menu
+    unordered_map<string, size_t> index;    // ID -> position in references
+
+} catalog_t;
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that checks that a list of tiers can be used by the
+ *         solver: not empty, starting at 1 unit, strictly increasing
+ *         min_unit and finite, non negative prices.
+ * @param  list  Tiers to check.
+ * @param  name  Name of the list for the error message.
+ * @param  error  Where the reason is stored if the list is not valid.
+ * @return true if the list is valid.
+ */
+inline bool validateTiers(const vector<cost_t> & list, const char * name,
+                          string * error)
+{
+    if (list.empty())
+    {
+        *error = string(name) + " no tiene ningún tramo";
+        return false;
+    }
+
+    if (list[0].min_unit != 1)
+    {
+        *error = string(name) + " debe empezar en 1 unidad";
+        return false;
+    }
+
+    for (size_t j = 0; j < list.size(); j++)
+    {
+        if ((j > 0) && (list[j].min_unit <= list[j - 1].min_unit))
+        {
+            *error = string(name) + " no está ordenada por unidades";
+            return false;
+        }
+
+        if (!isfinite(list[j].value) || (list[j].value < 0))
+        {
+            *error = string(name) + " tiene un precio negativo o no finito";
+            return false;
+        }
+    }
+
+    return true;
+
+}   /* validateTiers() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that checks that a cost model can be used by the solver:
+ *         a known policy of each kind and finite, non negative costs.
+ * @param  model  Cost model to check.
+ * @param  error  Where the reason is stored if the model is not valid.
+ * @return true if the model is valid.
+ */
+inline bool validateModel(const cost_model_t & model, string * error)
+{
+    if (((model.pricing != PRICING_ALL_UNITS) &&
+         (model.pricing != PRICING_INCREMENTAL)) ||
+        ((model.issue != ISSUE_TIERED) && (model.issue != ISSUE_FREIGHT)) ||
+        ((model.holding != HOLDING_PERCENTAGE) &&
+         (model.holding != HOLDING_ABSOLUTE)))
+    {
+        *error = "el modelo de costes no es válido";
+        return false;
+    }
+
+    if (!isfinite(model.freight) || (model.freight < 0) ||
+        !isfinite(model.holding_cost) || (model.holding_cost < 0))
+    {
+        *error = "el modelo de costes tiene un coste negativo o no finito";
+        return false;
+    }
+
+    return true;
+
+}   /* validateModel() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that validates a reference and appends it to the
+ *         catalog, adding its ID to the dictionary.
+ * @param  catalog  Catalog that receives the reference.
+ * @param  item  Reference to add.
+ * @param  error  Where the reason is stored if it cannot be added.
+ * @return true if the reference was added.
+ */
+inline bool addReference(catalog_t * catalog, const reference_t & item,
+                         string * error)
+{
+    if (item.id.empty())
+    {
+        *error = "la referencia no tiene ID";
+        return false;
+    }
+
+    if ((validateTiers(item.ca_list, "ca_list", error) == false) ||
+        (validateTiers(item.ce_list, "ce_list", error) == false))
+    {
+        *error = "'" + item.id + "': " + *error;
+        return false;
+    }
+
+    if (!isfinite(item.cp_percentage) || (item.cp_percentage < 0))
+    {
+        *error = "'" + item.id + "': cp_percentage es negativo o no finito";
+        return false;
+    }
+
+    if (validateModel(item.model, error) == false)
+    {
+        *error = "'" + item.id + "': " + *error;
+        return false;
+    }
+
+    if (catalog->index.insert({ item.id, catalog->references.size() }).second
+        == false)
+    {
+        *error = "la referencia '" + item.id + "' está repetida";
+        return false;
+    }
+
+    catalog->references.push_back(item);
+
+    return true;
+
+}   /* addReference() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that finds the position of a reference of the catalog
+ *         by its ID.
+ * @param  catalog  Catalog to search.
+ * @param  id  ID of the reference.
+ * @return Position of the reference, or -1 if it is not in the catalog.
+ */
+inline long findReferencePosition(const catalog_t * catalog,
+                                  const string & id)
+{
+    unordered_map<string, size_t>::const_iterator searched;
+    searched = catalog->index.find(id);
+
+    if (searched == catalog->index.end())
+    {
+        return -1;
+    }
+
+    return (long)searched->second;
+
+}   /* findReferencePosition() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that finds a reference of the catalog by its ID.
+ * @param  catalog  Catalog to search.
+ * @param  id  ID of the reference.
+ * @return Pointer to the reference, or NULL if it is not in the catalog.
+ */
+inline const reference_t * findReference(const catalog_t * catalog,
+                                         const string & id)
+{
+    long i = findReferencePosition(catalog, id);
+
+    return (i < 0) ? NULL : &(catalog->references[i]);
+
+}   /* findReference() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that adds bytes to a 64-bit FNV-1a hash.
+ * @param  h  Hash so far.
+ * @param  data  Bytes to add.
+ * @param  size  Number of bytes.
+ * @return New hash.
+ */
+inline uint64_t hashBytes(uint64_t h, const void * data, size_t size)
+{
+    const unsigned char * p = (const unsigned char *)data;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        h = (h ^ p[i]) * 0x100000001B3ull;
+    }
+
+    return h;
+
+}   /* hashBytes() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that computes the stamp of a catalog: a hash of the
+ *         ID, tiers, cp_percentage and cost model of every reference.
+ *         Any change of prices gives a different stamp, so results
+ *         cached for the old prices (see cache.h) are never used again.
+ *         The original model adds nothing, so the stamp of a catalog
+ *         that only uses it is the one of earlier versions.
+ * @param  catalog  Catalog of references.
+ * @return Stamp of the catalog.
+ */
+inline uint64_t catalogStamp(const catalog_t * catalog)
+{
+    uint64_t h = 0xCBF29CE484222325ull;
+
+    for (size_t i = 0; i < (catalog->references).size(); i++)
+    {
+        const reference_t & item = catalog->references[i];
+        size_t counts[2] = { item.ca_list.size(), item.ce_list.size() };
+
+        h = hashBytes(h, item.id.c_str(), item.id.size() + 1);
+        h = hashBytes(h, counts, sizeof(counts));
+        h = hashBytes(h, item.ca_list.data(),
+                      item.ca_list.size() * sizeof(cost_t));
+        h = hashBytes(h, item.ce_list.data(),
+                      item.ce_list.size() * sizeof(cost_t));
+        h = hashBytes(h, &(item.cp_percentage), sizeof(item.cp_percentage));
+
+        if (originalModel(&(item.model)) == false)
+        {
+            const cost_model_t & m = item.model;
+            int32_t policies[3] = { (int32_t)m.pricing, (int32_t)m.issue,
+                                    (int32_t)m.holding };
+
+            h = hashBytes(h, policies, sizeof(policies));
+            h = hashBytes(h, &(m.freight), sizeof(m.freight));
+            h = hashBytes(h, &(m.holding_cost), sizeof(m.holding_cost));
+        }
+    }
+
+    return h;
+
+}   /* catalogStamp() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that parses a list of "min_unit:value" tiers.
+ * @param  begin  First character of the field.
+ * @param  end  One past the last character of the field.
+ * @param  list  Where the tiers are stored.
+ * @return false if the field is malformed.
+ */
+inline bool parseTiers(const char * begin, const char * end,
+                       vector<cost_t> * list)
+{
+    const char * p = begin;
+
+    for (;;)
+    {
+        while ((p < end) && ((*p == ' ') || (*p == '\t')))
+        {
+            p++;
+        }
+
+        if (p == end)
+        {
+            return true;
+        }
+
+        cost_t tier;
+        char * next;
+
+        tier.min_unit = (int)strtol(p, &next, 10);
+
+        if ((next == p) || (next >= end) || (*next != ':'))
+        {
+            return false;
+        }
+
+        p = next + 1;
+        tier.value = strtof(p, &next);
+
+        if ((next == p) || (next > end))
+        {
+            return false;
+        }
+
+        list->push_back(tier);
+        p = next;
+
+        if ((p < end) && (*p != ' ') && (*p != '\t'))
+        {
+            return false;
+        }
+    }
+
+}   /* parseTiers() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that parses the cost model field of a catalog line.
+ * @param  begin  First character of the field.
+ * @param  end  One past the last character of the field.
+ * @param  model  Where the cost model is stored.
+ * @return false if some word of the field is not known.
+ */
+inline bool parseCostModel(const char * begin, const char * end,
+                           cost_model_t * model)
+{
+    const char * p = begin;
+
+    for (;;)
+    {
+        while ((p < end) && ((*p == ' ') || (*p == '\t')))
+        {
+            p++;
+        }
+
+        if (p == end)
+        {
+            return true;
+        }
+
+        const char * stop = p;
+
+        while ((stop < end) && (*stop != ' ') && (*stop != '\t'))
+        {
+            stop++;
+        }
+
+        string word(p, stop);
+        float * value = NULL;
+
+        if (word == "incremental")
+        {
+            model->pricing = PRICING_INCREMENTAL;
+        }
+        else if (word.compare(0, 8, "freight:") == 0)
+        {
+            model->issue = ISSUE_FREIGHT;
+            value = &(model->freight);
+        }
+        else if (word.compare(0, 8, "holding:") == 0)
+        {
+            model->holding = HOLDING_ABSOLUTE;
+            value = &(model->holding_cost);
+        }
+        else
+        {
+            return false;
+        }
+
+        if (value != NULL)
+        {
+            const char * number = word.c_str() + 8;
+            char * next;
+
+            *value = strtof(number, &next);
+
+            if ((next == number) || (*next != '\0'))
+            {
+                return false;
+            }
+        }
+
+        p = stop;
+    }
+
+}   /* parseCostModel() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that parses one line of a catalog file.
+ * @param  begin  First character of the line.
+ * @param  end  One past the last character of the line.
+ * @param  item  Where the reference is stored.
+ * @return false if the line does not have the five (or six) expected
+ *         fields.
+ */
+inline bool parseCatalogLine(const char * begin, const char * end,
+                             reference_t * item)
+{
+    const char * field[6];
+    int fields = 1;
+
+    field[0] = begin;
+
+    for (const char * p = begin; p < end; p++)
+    {
+        if (*p == ';')
+        {
+            if (fields == 6)
+            {
+                return false;
+            }
+
+            field[fields++] = p + 1;
+        }
+    }
+
+    if (fields < 5)
+    {
+        return false;
+    }
+
+    item->model = {};
+
+    if (fields == 6)
+    {
+        if (parseCostModel(field[5], end, &(item->model)) == false)
+        {
+            return false;
+        }
+
+        end = field[5] - 1;
+    }
+
+    item->id.assign(field[0], field[1] - 1);
+    item->description.assign(field[1], field[2] - 1);
+
+    if ((parseTiers(field[2], field[3] - 1, &(item->ca_list)) == false) ||
+        (parseTiers(field[3], field[4] - 1, &(item->ce_list)) == false))
+    {
+        return false;
+    }
+
+    char * next;
+    item->cp_percentage = strtof(field[4], &next);
+
+    while ((next < end) && (*next == ' '))
+    {
+        next++;
+    }
+
+    return (next != field[4]) && (next == end);
+
+}   /* parseCatalogLine() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that loads a catalog file (see the format at the top
+ *         of this file). The whole file is read with a single fread()
+ *         and parsed in place, so catalogs of 100k references load in
+ *         a fraction of a second.
+ * @param  path  Path of the catalog file.
+ * @param  catalog  Where the references are added.
+ * @param  error  Where the reason is stored if the file is not valid.
+ * @return true if every reference of the file was loaded.
+ */
+inline bool loadCatalog(const char * path, catalog_t * catalog,
+                        string * error)
+{
+    FILE * file = fopen(path, "rb");
+
+    if (file == NULL)
+    {
+        *error = string("no se puede abrir el fichero '") + path + "'";
+        return false;
+    }
+
+    string text;
+    char block[1 << 16];
+    size_t n;
+
+    while ((n = fread(block, 1, sizeof(block), file)) > 0)
+    {
+        text.append(block, n);
+    }
+
+    fclose(file);
+
+    // Reserve for the expected number of references, one per line
+    size_t lines = 0;
+
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        lines += (text[i] == '\n');
+    }
+
+    catalog->references.reserve(catalog->references.size() + lines + 1);
+    catalog->index.reserve(catalog->references.size() + lines + 1);
+
+    const char * p = text.c_str();
+    const char * stop = p + text.size();
+    int lineNumber = 0;
+
+    while (p < stop)
+    {
+        const char * end = (const char *)memchr(p, '\n', stop - p);
+
+        if (end == NULL)
+        {
+            end = stop;
+        }
+
+        const char * next = end + 1;
+        lineNumber++;
+
+        if ((end > p) && (end[-1] == '\r'))
+        {
+            end--;
+        }
+
+        if ((end > p) && (*p != '#'))
+        {
+            reference_t item;
+
+            if (parseCatalogLine(p, end, &item) == false)
+            {
+                *error = "línea " + to_string(lineNumber) + ": se esperaba " +
+                         "'id;descripción;ca_list;ce_list;cp_percentage" +
+                         "[;modelo]'";
+                return false;
+            }
+
+            if (addReference(catalog, item, error) == false)
+            {
+                *error = "línea " + to_string(lineNumber) + ": " + *error;
+                return false;
+            }
+        }
+
+        p = next;
+    }
+
+    return true;
+
+}   /* loadCatalog() */
+
+#endif /* CATALOG_H */
+
+/*** end of file ***/
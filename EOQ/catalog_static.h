@@ -0,0 +1,113 @@
+/**
+ * @file     catalog_static.h
+ *
+ * @section  LIO-GIIROB
+ * @brief    Catalog of references as constexpr data, written by
+ *           optimalQ --export-static (see static_catalog.h). Build
+ *           with g++ -DEOQ_STATIC_CATALOG to use it.
+ */
+
+#ifndef CATALOG_STATIC_H
+#define CATALOG_STATIC_H
+
+#define STATIC_MAX_TIERS 15
+
+#include "static_catalog.h"
+
+constexpr static_reference_t STATIC_REFERENCES[] =
+{
+    { "NVLS745", "Envase de miel  1 kg liso V720", 0.16f,
+       4, { { 1, 0.55f }, { 50, 0.54f }, { 150, 0.53f },
+            { 1176, 0.34f } },
+      14, { { 1, 3.95f }, { 7, 4.95f }, { 38, 5.9f },
+            { 60, 6.95f }, { 75, 8.89f }, { 115, 14.9f },
+            { 186, 16.9f }, { 223, 18.76f }, { 256, 25.89f },
+            { 334, 29.98f }, { 445, 48.4f }, { 482, 59.29f },
+            { 2223, 119.79f }, { 4815, 227.48f } } },
+    { "110212", "Tapa TO 77mm dorada pasteurizable", 0.1f,
+       4, { { 1, 0.18f }, { 100, 0.17f }, { 200, 0.16f },
+            { 950, 0.12f } },
+       7, { { 1, 3.95f }, { 200, 4.95f }, { 1000, 5.9f },
+            { 1600, 6.95f }, { 2000, 8.89f }, { 3000, 14.9f },
+            { 5001, 16.9f } } },
+    { "260024045", "Rollo de 500 etiquetas (de cualquier tipo)", 0.09f,
+       1, { { 1, 24.95f } },
+       1, { { 1, 3.95f } } },
+    { "260024046", "Rollo de 1000 etiquetas de precinto para botes", 0.09f,
+       1, { { 1, 29.95f } },
+       1, { { 1, 3.95f } } },
+    { "303117", "Caja de cartón para 12 tarros V720", 0.14f,
+       2, { { 1, 0.65f }, { 100, 0.55f } },
+      14, { { 1, 3.95f }, { 20, 4.95f }, { 100, 5.9f },
+            { 160, 6.95f }, { 200, 8.89f }, { 310, 14.9f },
+            { 501, 16.9f }, { 600, 18.76f }, { 690, 25.89f },
+            { 900, 29.98f }, { 1200, 48.4f }, { 1300, 59.29f },
+            { 6000, 119.79f }, { 13000, 227.48f } } },
+    { "110102", "Envase de 0,5 kg celdilla", 0.15f,
+       5, { { 1, 0.45f }, { 100, 0.43f }, { 500, 0.41f },
+            { 1040, 0.37f }, { 2097, 0.27f } },
+      14, { { 1, 3.95f }, { 7, 4.95f }, { 35, 5.9f },
+            { 56, 6.95f }, { 69, 8.89f }, { 107, 14.9f },
+            { 173, 16.9f }, { 207, 18.76f }, { 238, 25.89f },
+            { 311, 29.98f }, { 414, 48.4f }, { 449, 59.29f },
+            { 2069, 119.79f }, { 4483, 227.48f } } },
+    { "110207", "Tapa TO 66 mm dorada pasteurizable", 0.1f,
+       4, { { 1, 0.18f }, { 300, 0.16f }, { 1500, 0.12f },
+            { 2500, 0.1f } },
+       6, { { 1, 3.95f }, { 250, 4.95f }, { 1250, 5.9f },
+            { 2000, 6.95f }, { 2500, 8.89f }, { 3875, 14.9f } } },
+    { "CAJ1205", "Caja de cartón 12 frascos miel 1/2 kg", 0.13f,
+       1, { { 1, 0.65f } },
+      15, { { 1, 3.95f }, { 10, 4.95f }, { 50, 5.9f },
+            { 80, 6.95f }, { 100, 8.89f }, { 155, 14.9f },
+            { 251, 16.9f }, { 300, 18.76f }, { 345, 25.89f },
+            { 450, 29.98f }, { 600, 48.4f }, { 650, 59.29f },
+            { 3000, 119.79f }, { 6500, 227.48f }, { 9715, 286.77f } } },
+    { "STO69015", "Topacio 20 ml para jalea PP28 sin tapón", 0.13f,
+       2, { { 1, 0.26f }, { 156, 0.18f } },
+       1, { { 1, 3.95f } } },
+    { "tapon-PP28", "Tapón PP28 para topacios", 0.1f,
+       1, { { 1, 0.14f } },
+       1, { { 1, 3.95f } } },
+    { "CUDOS/1000", "Cuchara para jalea real 1000 ud.", 0.09f,
+       1, { { 1, 24.9f } },
+       4, { { 1, 3.95f }, { 2000, 4.95f }, { 10000, 5.9f },
+            { 16000, 6.95f } } },
+    { "30ml-DIN18", "Topacio ámbar para propóleos 30 ml DIN18", 0.13f,
+       2, { { 1, 0.37f }, { 115, 0.27f } },
+       4, { { 1, 3.95f }, { 2000, 4.95f }, { 10000, 5.9f },
+            { 16000, 6.95f } } },
+    { "tapon-spray", "Tapón spray de envase para propoleo", 0.08f,
+       1, { { 1, 0.69f } },
+       2, { { 1, 5.99f }, { 66, 0.0f } } },
+    { "caja_01", "Embalajes para jalea real", 0.1f,
+       1, { { 1, 0.15f } },
+       1, { { 1, 3.95f } } },
+    { "caja_02", "Caja de cartón para 24 de jalea real", 0.12f,
+       1, { { 1, 0.55f } },
+       1, { { 1, 3.95f } } },
+    { "caja_03", "Embalajes para propóleo", 0.1f,
+       1, { { 1, 0.15f } },
+       1, { { 1, 3.95f } } },
+    { "caja_04", "Caja de cartón para 24 de propóleo", 0.12f,
+       1, { { 1, 0.55f } },
+       1, { { 1, 3.95f } } }
+};
+
+constexpr size_t STATIC_COUNT =
+    sizeof(STATIC_REFERENCES) / sizeof(STATIC_REFERENCES[0]);
+
+constexpr static_index_t<STATIC_COUNT> STATIC_INDEX =
+{
+    { 2, 1, 5, 4, 1 },
+    { -1, -1, 2, -1, -1, 7, 12, -1, 9, 4, 3, -1,
+      -1, -1, 1, 8, -1, 15, 14, 6, -1, -1, -1, 11,
+      16, 5, -1, 10, -1, 13, -1, -1, -1, 0 }
+};
+
+static_assert(checkStaticIndex(STATIC_REFERENCES, STATIC_INDEX),
+              "STATIC_INDEX is not the index of the IDs");
+
+#endif /* CATALOG_STATIC_H */
+
+/*** end of file ***/
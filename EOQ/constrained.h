@@ -0,0 +1,284 @@
+/**
+ * @file     constrained.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Orders of many references under a cap on the value of the
+ *           average stock (working capital) and/or on its volume
+ *           (warehouse space), by Lagrangian relaxation.
+ *
+ *           With multipliers λ (value) and μ (volume), each reference
+ *           minimises on its own
+ *
+ *             CT(Q) + λ·ca·Q/2 + μ·v·Q/2
+ *
+ *           that is, its tiered problem with a holding cost per unit of
+ *           ca·(cp_percentage + λ) + μ·v, solved segment by segment in
+ *           closed form as in eoq.h. The stock that the solutions hold
+ *           never grows with a multiplier, so the smallest λ (and μ)
+ *           that meets each cap is found by bisection, and every step
+ *           re-solves all the references in parallel (see threadpool.h).
+ *
+ *           The tiers make the problem discrete, so the plan meets the
+ *           caps but may leave a little of them unused (the duality gap).
+ *           With both caps, μ is searched on top of the λ that meets the
+ *           value cap for each μ.
+ */
+
+#ifndef CONSTRAINED_H
+#define CONSTRAINED_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "eoq.h"
+#include "threadpool.h"
+
+#include <functional>
+#include <math.h>
+#include <vector>
+
+using namespace std;
+
+//-----[ CONSTANTS ]----------------------------------------------------------//
+
+// Relative width at which the bisection of a multiplier stops
+#define LAGRANGE_TOLERANCE 1e-7
+
+// Largest multiplier tried before a cap is taken as unreachable
+#define LAGRANGE_MAX 1e12
+
+// References that a thread solves each time it takes work
+#define LAGRANGE_GRAIN 64
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef struct
+{
+    tiers_t tiers;
+    int D;          // Annual demand
+    double volume;  // Volume of one unit
+    int Q;          // Units of each order
+    float ca;       // Acquisition cost of the tier of Q
+    float ce;       // Cost of issue of the tier of Q
+    float cp;       // Cost of ownership of the tier of Q
+    double CT;      // Annual total cost of Q (without the multipliers)
+
+} constrained_item_t;
+
+typedef struct
+{
+    double value;   // Cap on the value of the average stock (<= 0: none)
+    double volume;  // Cap on the volume of the average stock (<= 0: none)
+
+} stock_caps_t;
+
+typedef struct
+{
+    double lambda;  // Multiplier of the value cap
+    double mu;      // Multiplier of the volume cap
+    double value;   // Value of the average stock, sum of ca·Q/2
+    double volume;  // Volume of the average stock, sum of v·Q/2
+    double CT;      // Annual total cost of the plan
+
+} constrained_plan_t;
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that finds the Q of a reference that minimises its CT
+ *         plus the cost of the multipliers, over [1, 2·D].
+ * @param  item  Reference, whose Q, prices and CT are updated.
+ * @param  lambda  Multiplier of the value of the stock.
+ * @param  mu  Multiplier of the volume of the stock.
+ * @return void
+ */
+inline void lagrangianQ(constrained_item_t * item, double lambda, double mu)
+{
+    const tiers_t * tiers = &(item->tiers);
+    int D = item->D;
+    double best = HUGE_VAL;
+    segment_t seg = { 0, 0, 0, 0 };
+
+    while (nextSegment(tiers, D * 2, &seg))
+    {
+        float ca = (tiers->ca_list[seg.i]).value;
+        float ce = (tiers->ce_list[seg.j]).value;
+        double h = ca * (tiers->cp_percentage + lambda) + mu * item->volume;
+        double q;
+
+        if ((ce > 0) && (h > 0))
+        {
+            q = sqrt(2.0 * ce * (double)D / h);
+        }
+        else
+        {
+            // The cost is monotonic: decreasing with no holding cost
+            q = (ce > 0) ? seg.hi : seg.lo;
+        }
+
+        if (q < seg.lo) q = seg.lo;
+        if (q > seg.hi) q = seg.hi;
+
+        int Q = (int)floor(q);
+        double cost = (ce * (double)D / Q) + (h * Q / 2.0);
+
+        if ((Q < seg.hi) &&
+            ((ce * (double)D / (Q + 1)) + (h * (Q + 1) / 2.0) < cost))
+        {
+            Q++;
+            cost = (ce * (double)D / Q) + (h * Q / 2.0);
+        }
+
+        cost += ca * (double)D;
+
+        if (cost < best)
+        {
+            best = cost;
+            item->Q = Q;
+            item->ca = ca;
+            item->ce = ce;
+        }
+    }
+
+    item->cp = tiers->cp_percentage * item->ca;
+    item->CT = modelCT(D, item->Q, item->ca, item->ce, item->cp);
+
+}   /* lagrangianQ() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that re-solves every reference with some multipliers,
+ *         in parallel, and adds up the stock and the cost of the plan.
+ * @param  items  References, updated in place.
+ * @param  lambda  Multiplier of the value of the stock.
+ * @param  mu  Multiplier of the volume of the stock.
+ * @param  threads  Number of threads.
+ * @param  plan  Where the multipliers, stock and cost are stored.
+ * @return void
+ */
+inline void solveAtMultipliers(vector<constrained_item_t> * items,
+                               double lambda, double mu, int threads,
+                               constrained_plan_t * plan)
+{
+    auto solve = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            lagrangianQ(&(*items)[i], lambda, mu);
+        }
+    };
+
+    parallelFor(items->size(), threads, LAGRANGE_GRAIN, solve);
+
+    plan->lambda = lambda;
+    plan->mu = mu;
+    plan->value = 0.0;
+    plan->volume = 0.0;
+    plan->CT = 0.0;
+
+    for (const constrained_item_t & item : *items)
+    {
+        plan->value += item.ca * (double)item.Q / 2.0;
+        plan->volume += item.volume * item.Q / 2.0;
+        plan->CT += item.CT;
+    }
+
+}   /* solveAtMultipliers() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that finds the smallest multiplier that meets a cap,
+ *         given that a larger one never uses more of it: the multiplier
+ *         grows until the cap is met, and then it is bisected.
+ * @param  meets  Solves with a multiplier and tells if the cap is met.
+ * @return Multiplier found, or a negative value if even LAGRANGE_MAX
+ *         does not meet the cap. The last call to meets() is with it.
+ */
+inline double bisectMultiplier(const function<bool(double)> & meets)
+{
+    if (meets(0.0))
+    {
+        return 0.0;
+    }
+
+    double lo = 0.0;
+    double hi = 1.0;
+
+    while (meets(hi) == false)
+    {
+        lo = hi;
+        hi *= 4.0;
+
+        if (hi > LAGRANGE_MAX)
+        {
+            return -1.0;
+        }
+    }
+
+    while (hi - lo > LAGRANGE_TOLERANCE * hi)
+    {
+        double middle = (lo + hi) / 2.0;
+
+        if (meets(middle))
+        {
+            hi = middle;
+        }
+        else
+        {
+            lo = middle;
+        }
+    }
+
+    // Leave the caller with the plan that meets the cap
+    meets(hi);
+
+    return hi;
+
+}   /* bisectMultiplier() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that finds the orders of many references with the
+ *         lowest total CT whose average stock meets the caps.
+ * @param  items  References (D > 0), left with their constrained orders.
+ * @param  caps  Caps on the value and on the volume of the stock.
+ * @param  threads  Number of threads.
+ * @param  plan  Where the multipliers, stock and cost are stored.
+ * @return false if the caps cannot be met even ordering 1 unit.
+ */
+inline bool solveConstrained(vector<constrained_item_t> * items,
+                             const stock_caps_t * caps, int threads,
+                             constrained_plan_t * plan)
+{
+    bool capValue = (caps->value > 0);
+    bool capVolume = (caps->volume > 0);
+
+    // λ that meets the value cap for a given μ (0 with no value cap)
+    auto meetsValue = [&](double mu)
+    {
+        auto meets = [&](double lambda)
+        {
+            solveAtMultipliers(items, lambda, mu, threads, plan);
+
+            return (capValue == false) || (plan->value <= caps->value);
+        };
+
+        return bisectMultiplier(meets) >= 0.0;
+    };
+
+    // μ that meets the volume cap, each with the λ of the value cap
+    auto meetsBoth = [&](double mu)
+    {
+        return meetsValue(mu) &&
+               ((capVolume == false) || (plan->volume <= caps->volume));
+    };
+
+    return bisectMultiplier(meetsBoth) >= 0.0;
+
+}   /* solveConstrained() */
+
+#endif /* CONSTRAINED_H */
+
+/*** end of file ***/
@@ -0,0 +1,299 @@
+/**
+ * @file     curve.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Export of the cost curve CA, CE, CP and CT versus Q of a
+ *           reference, for charts such as example.png, with a number of
+ *           points that does not grow with D.
+ *
+ *           [1, 2·D] is split into the segments of eoq.h, where ca and
+ *           ce stay fixed and CT is smooth and convex. Every segment gets
+ *           exact points at both ends (the curve jumps at each ca_list or
+ *           ce_list breakpoint, between the last Q of a segment and the
+ *           first one of the next), at its own optimum and at the Q* of
+ *           solveOptimalQ(). Between them, the points go where the curve
+ *           bends most: the interval whose midpoint is farthest from the
+ *           chord is split first, until every midpoint is within
+ *           tolerance · (range of CT) of its chord or the segment has
+ *           used its samples.
+ *
+ *           The values are the ones of evaluateQ(), so the point at Q*
+ *           is the row of the batch output. The points are written as
+ *           CSV or in a binary file (native byte order):
+ *
+ *             curve_header_t   Magic, version, count and D.
+ *             curve_point_t    One per point, in increasing Q.
+ */
+
+#ifndef CURVE_H
+#define CURVE_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "eoq.h"
+
+#include <algorithm>
+#include <math.h>
+#include <queue>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//-----[ CONSTANTS ]----------------------------------------------------------//
+
+#define CURVE_MAGIC   "EOQCURV"
+#define CURVE_VERSION 1
+
+// Points added inside each segment at most, and the default ones
+#define CURVE_MAX_SAMPLES     4096
+#define CURVE_DEFAULT_SAMPLES 64
+
+// Largest distance from a midpoint to its chord, in parts of the CT range
+#define CURVE_TOLERANCE 1e-3
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef struct
+{
+    char magic[8];          // CURVE_MAGIC
+    uint32_t version;       // CURVE_VERSION
+    uint32_t count;         // Number of points
+    int32_t D;              // Annual Demand of the curve
+    uint32_t reserved;
+
+} curve_header_t;
+
+typedef struct
+{
+    int32_t Q;
+    int32_t segment;        // Points of one segment can be joined by lines
+    float CA;
+    float CE;
+    float CP;
+    float CT;
+
+} curve_point_t;
+
+typedef struct
+{
+    double error;           // Distance from the midpoint to the chord
+    int a;                  // Ends of the interval
+    int b;
+
+} curve_gap_t;
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that measures how far the curve of a segment is from the
+ *         chord of an interval, at its midpoint.
+ * @param  D  Annual Demand.
+ * @param  a  First Q of the interval.
+ * @param  b  Last Q of the interval (at least a + 2).
+ * @param  ca  Acquisition cost of the segment.
+ * @param  ce  Cost of issue of the segment.
+ * @param  cp  Cost of ownership of the segment.
+ * @return Interval with its distance.
+ */
+inline curve_gap_t curveGap(int D, int a, int b, float ca, float ce, float cp)
+{
+    int m = a + (b - a) / 2;
+    double chord = modelCT(D, a, ca, ce, cp) +
+                   (modelCT(D, b, ca, ce, cp) - modelCT(D, a, ca, ce, cp)) *
+                   ((double)(m - a) / (b - a));
+
+    return { fabs(modelCT(D, m, ca, ce, cp) - chord), a, b };
+
+}   /* curveGap() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that places the points of the cost curve (see the top
+ *         of the file).
+ * @param  D  Annual Demand (positive, up to INT_MAX / 2).
+ * @param  tiers  Tiers of the reference.
+ * @param  samples  Points that each segment may add between its fixed
+ *                  ones (up to CURVE_MAX_SAMPLES).
+ * @param  tolerance  Distance to the chord that is good enough, in parts
+ *                    of the CT range of the curve.
+ * @param  points  Where the points, in increasing Q, are stored.
+ * @return void
+ */
+inline void sampleCurve(int D, const tiers_t * tiers, int samples,
+                        double tolerance, vector<curve_point_t> * points)
+{
+    vector<segment_t> segments;
+    vector<vector<int>> fixed;
+    segment_t seg = { 0, 0, 0, 0 };
+    int Q_star = solveOptimalQ(D, tiers).Q;
+    double low = HUGE_VAL, high = -HUGE_VAL;
+
+    // Fixed points of every segment, and the range of CT
+    while (nextSegment(tiers, D * 2, &seg))
+    {
+        float ca = (tiers->ca_list[seg.i]).value;
+        float ce = (tiers->ce_list[seg.j]).value;
+        float cp = tiers->cp_percentage * ca;
+        vector<int> Q = { seg.lo, segmentOptimalQ(D, tiers, &seg), seg.hi };
+
+        if ((Q_star >= seg.lo) && (Q_star <= seg.hi))
+        {
+            Q.push_back(Q_star);
+        }
+
+        sort(Q.begin(), Q.end());
+        Q.erase(unique(Q.begin(), Q.end()), Q.end());
+
+        for (int q : Q)
+        {
+            low = min(low, modelCT(D, q, ca, ce, cp));
+            high = max(high, modelCT(D, q, ca, ce, cp));
+        }
+
+        segments.push_back(seg);
+        fixed.push_back(Q);
+    }
+
+    double limit = tolerance * (high - low);
+
+    points->clear();
+
+    for (size_t s = 0; s < segments.size(); s++)
+    {
+        const segment_t & sg = segments[s];
+        float ca = (tiers->ca_list[sg.i]).value;
+        float ce = (tiers->ce_list[sg.j]).value;
+        float cp = tiers->cp_percentage * ca;
+        vector<int> Q = fixed[s];
+        auto wider = [](const curve_gap_t & x, const curve_gap_t & y)
+        {
+            return x.error < y.error;
+        };
+        priority_queue<curve_gap_t, vector<curve_gap_t>, decltype(wider)>
+            gaps(wider);
+
+        for (size_t k = 1; k < Q.size(); k++)
+        {
+            if (Q[k] - Q[k - 1] >= 2)
+            {
+                gaps.push(curveGap(D, Q[k - 1], Q[k], ca, ce, cp));
+            }
+        }
+
+        // Split the interval that is farthest from its chord first
+        for (int added = 0; (added < samples) && !gaps.empty(); added++)
+        {
+            curve_gap_t gap = gaps.top();
+
+            if (gap.error <= limit)
+            {
+                break;
+            }
+
+            gaps.pop();
+
+            int m = gap.a + (gap.b - gap.a) / 2;
+
+            Q.push_back(m);
+
+            if (m - gap.a >= 2)
+            {
+                gaps.push(curveGap(D, gap.a, m, ca, ce, cp));
+            }
+
+            if (gap.b - m >= 2)
+            {
+                gaps.push(curveGap(D, m, gap.b, ca, ce, cp));
+            }
+        }
+
+        sort(Q.begin(), Q.end());
+
+        for (int q : Q)
+        {
+            solution_t v = evaluateQ(D, q, ca, ce, tiers->cp_percentage);
+
+            points->push_back({ q, (int32_t)s, v.CA, v.CE, v.CP, v.CT });
+        }
+    }
+
+}   /* sampleCurve() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that writes the points of a curve as CSV or binary.
+ * @param  points  Points of the curve.
+ * @param  D  Annual Demand of the curve.
+ * @param  binary  Whether to write the binary format instead of CSV.
+ * @param  path  File to write, or NULL for stdout.
+ * @param  error  Where the reason is stored if it cannot be written.
+ * @return true if the whole curve was written.
+ */
+inline bool exportCurve(const vector<curve_point_t> & points, int D,
+                        bool binary, const char * path, string * error)
+{
+    FILE * file = (path != NULL) ? fopen(path, binary ? "wb" : "w") : stdout;
+
+    if (file == NULL)
+    {
+        *error = string("no se puede crear el fichero '") + path + "'";
+        return false;
+    }
+
+    bool ok = true;
+
+    if (binary)
+    {
+        curve_header_t header;
+
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, CURVE_MAGIC, sizeof(header.magic));
+        header.version = CURVE_VERSION;
+        header.count = (uint32_t)points.size();
+        header.D = D;
+
+        ok = (fwrite(&header, sizeof(header), 1, file) == 1) &&
+             (fwrite(points.data(), sizeof(curve_point_t), points.size(),
+                     file) == points.size());
+    }
+    else
+    {
+        string out = "Q,segment,CA,CE,CP,CT\n";
+        char row[160];
+
+        for (const curve_point_t & p : points)
+        {
+            snprintf(row, sizeof(row), "%d,%d,%.2f,%.2f,%.2f,%.2f\n", p.Q,
+                     p.segment, p.CA, p.CE, p.CP, p.CT);
+            out += row;
+        }
+
+        ok = (fwrite(out.data(), 1, out.size(), file) == out.size());
+    }
+
+    ok = (fflush(file) == 0) && ok;
+
+    if (path != NULL)
+    {
+        ok = (fclose(file) == 0) && ok;
+    }
+
+    if (ok == false)
+    {
+        *error = "no se ha podido escribir la curva";
+    }
+
+    return ok;
+
+}   /* exportCurve() */
+
+#endif /* CURVE_H */
+
+/*** end of file ***/
@@ -0,0 +1,388 @@
+/**
+ * @file     eoq.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Header-only solver of the optimal Q of a reference. It only
+ *           computes: it does no I/O and no allocation, so it can be
+ *           called in-process as many times as needed. The table of the
+ *           terminal program is drawn apart, in render.h.
+ *
+ *             #include "eoq.h"
+ *
+ *             solution_t s = solveOptimalQ(D, &item);    // reference_t
+ *             solution_t t = solveOptimalQ(D, &tiers);   // tiers_t view
+ */
+
+#ifndef EOQ_H
+#define EOQ_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "types.h"
+#include "tiers.h"
+
+#include <math.h>
+
+using namespace std;
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef struct
+{
+    int Q;
+    float ca;
+    float ce;
+    float cp;
+    float CA;
+    float CE;
+    float CP;
+    float CT;
+
+} solution_t;
+
+typedef struct
+{
+    int i;      // Active tier of ca_list
+    int j;      // Active tier of ce_list
+    int lo;     // First Q of the segment
+    int hi;     // Last Q of the segment
+
+} segment_t;
+
+//-----[ CONSTANTS ]----------------------------------------------------------//
+
+// Relative margin (a few float ulps) that covers the rounding error of CT
+#define CT_TOLERANCE 1e-6
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that calculates ca, ce, cp, CA, CE, CP and CT for
+ *         an order of Q units. The arithmetic is exactly the one of
+ *         the original exhaustive scan, so a given Q always gets the
+ *         same (float) CT no matter which solver evaluates it.
+ * @param  D  Annual demand for the reference.
+ * @param  Q  Units of each order.
+ * @param  ca  Acquisition cost of the tier that contains Q.
+ * @param  ce  Cost of issue of the tier that contains Q.
+ * @param  cp_percentage  Cost of ownership (% of Acquisition Cost).
+ * @return Costs of ordering Q units.
+ */
+inline solution_t evaluateQ(int D, int Q, float ca, float ce,
+                            float cp_percentage)
+{
+    solution_t s;
+
+    s.Q  = Q;
+    s.ca = ca;
+    s.ce = ce;
+    s.cp = cp_percentage * ca;
+    s.CA = ca * (D * 1.0);
+    s.CE = ce * ((D * 1.0) / (Q * 1.0));
+    s.CP = s.cp * ((Q * 1.0) / 2.0);
+    s.CT = s.CA + s.CE + s.CP;
+
+    return s;
+
+}   /* evaluateQ() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that calculates the costs of ordering any Q units,
+ *         looking up its ca and ce tiers with findTier(). A single
+ *         evaluation costs O(log tiers).
+ * @param  D  Annual demand for the reference.
+ * @param  Q  Units of each order (at least 1).
+ * @param  tiers  Tiers of the reference.
+ * @return Costs of ordering Q units.
+ */
+inline solution_t evaluateCT(int D, int Q, const tiers_t * tiers)
+{
+    float ca, ce;
+
+    tierPrices(tiers, Q, &ca, &ce);
+
+    return evaluateQ(D, Q, ca, ce, tiers->cp_percentage);
+
+}   /* evaluateCT() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that computes the last Q of a segment, that is, the
+ *         unit right before the next ca or ce breakpoint (or Q_max).
+ * @param  tiers  Tiers of the reference.
+ * @param  Q_max  Last Q that is considered.
+ * @param  seg  Segment whose tiers and first Q are already set.
+ * @return void
+ */
+inline void closeSegment(const tiers_t * tiers, int Q_max, segment_t * seg)
+{
+    seg->hi = Q_max;
+
+    if ((seg->i + 1 < tiers->ca_count) &&
+        ((tiers->ca_list[seg->i + 1]).min_unit - 1 < seg->hi))
+    {
+        seg->hi = (tiers->ca_list[seg->i + 1]).min_unit - 1;
+    }
+
+    if ((seg->j + 1 < tiers->ce_count) &&
+        ((tiers->ce_list[seg->j + 1]).min_unit - 1 < seg->hi))
+    {
+        seg->hi = (tiers->ce_list[seg->j + 1]).min_unit - 1;
+    }
+
+}   /* closeSegment() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that moves to the next range of Q in which both the
+ *         ca and the ce tiers stay fixed. The first call must receive
+ *         a segment with hi = 0.
+ * @param  tiers  Tiers of the reference.
+ * @param  Q_max  Last Q that is considered.
+ * @param  seg  Current segment, updated in place.
+ * @return false if there are no more segments below Q_max.
+ */
+inline bool nextSegment(const tiers_t * tiers, int Q_max, segment_t * seg)
+{
+    seg->lo = seg->hi + 1;
+
+    if (seg->lo > Q_max)
+    {
+        return false;
+    }
+
+    // Tiers that apply to the first Q of the segment
+    seg->i = findTier(tiers->ca_list, tiers->ca_count, seg->lo);
+    seg->j = findTier(tiers->ce_list, tiers->ce_count, seg->lo);
+
+    closeSegment(tiers, Q_max, seg);
+
+    return true;
+
+}   /* nextSegment() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that evaluates CT = ca·D + ce·D/Q + cp·Q/2 in double
+ *         precision, i.e. without the rounding of evaluateQ().
+ * @param  D  Annual demand for the reference.
+ * @param  Q  Units of each order.
+ * @param  ca  Acquisition cost of the segment.
+ * @param  ce  Cost of issue of the segment.
+ * @param  cp  Cost of ownership of the segment.
+ * @return Exact CT of the segment at Q.
+ */
+inline double modelCT(int D, int Q, float ca, float ce, float cp)
+{
+    return (ca * (double)D) + (ce * (double)D / Q) + (cp * (double)Q / 2.0);
+
+}   /* modelCT() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that finds the integer Q with the lowest modelCT()
+ *         inside a segment. CT is convex there, so it is enough to
+ *         clamp the continuous EOQ sqrt(2·ce·D/cp) to the segment and
+ *         to compare the two integers around it.
+ * @param  D  Annual demand for the reference.
+ * @param  tiers  Tiers of the reference.
+ * @param  seg  Segment to minimise.
+ * @return Best integer Q of the segment.
+ */
+inline int segmentOptimalQ(int D, const tiers_t * tiers,
+                           const segment_t * seg)
+{
+    float ca = (tiers->ca_list[seg->i]).value;
+    float ce = (tiers->ce_list[seg->j]).value;
+    float cp = tiers->cp_percentage * ca;
+    double q;
+
+    if ((ce > 0) && (cp > 0))
+    {
+        q = sqrt(2.0 * ce * (double)D / cp);
+    }
+    else
+    {
+        // CT is monotonic: decreasing with no holding cost, else increasing
+        q = (ce > 0) ? seg->hi : seg->lo;
+    }
+
+    // Clamp the continuous optimum to the segment bounds
+    if (q < seg->lo) q = seg->lo;
+    if (q > seg->hi) q = seg->hi;
+
+    int q_floor = (int)floor(q);
+    int q_ceil = (q_floor < seg->hi) ? (q_floor + 1) : q_floor;
+
+    if (modelCT(D, q_ceil, ca, ce, cp) < modelCT(D, q_floor, ca, ce, cp))
+    {
+        return q_ceil;
+    }
+
+    return q_floor;
+
+}   /* segmentOptimalQ() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that finds the optimum of the exact cost modelCT()
+ *         over [1, 2·D]: the segment whose best integer Q has the
+ *         lowest CT (the first one on a tie). D must be positive.
+ * @param  D  Annual demand for the reference.
+ * @param  tiers  Tiers of the reference.
+ * @param  best  Where the winning segment is stored.
+ * @param  Q  Where the best Q of that segment is stored.
+ * @return Lowest exact CT.
+ */
+inline double modelOptimum(int D, const tiers_t * tiers, segment_t * best,
+                           int * Q)
+{
+    double min_CT = HUGE_VAL;
+    segment_t seg = { 0, 0, 0, 0 };
+
+    while (nextSegment(tiers, D * 2, &seg))
+    {
+        float ca = (tiers->ca_list[seg.i]).value;
+        float ce = (tiers->ce_list[seg.j]).value;
+        float cp = tiers->cp_percentage * ca;
+        int q = segmentOptimalQ(D, tiers, &seg);
+        double CT = modelCT(D, q, ca, ce, cp);
+
+        if (CT < min_CT)
+        {
+            min_CT = CT;
+            *best = seg;
+            *Q = q;
+        }
+    }
+
+    return min_CT;
+
+}   /* modelOptimum() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that finds, among every Q whose exact CT is within
+ *         CT_TOLERANCE of the lowest one (the only ones whose float CT
+ *         can still win), the first Q with the lowest float CT of
+ *         evaluateQ(), as the exhaustive scan does. CT is convex in each
+ *         segment, so the candidates of a segment are contiguous and the
+ *         segments without any are skipped after one evaluation.
+ * @param  D  This number indicates the annual demand for the reference.
+ * @param  tiers  Tiers of the reference.
+ * @param  min_CT  Lowest exact CT (from modelOptimum()).
+ * @return Costs of the optimal order.
+ */
+inline solution_t windowOptimalQ(int D, const tiers_t * tiers,
+                                 double min_CT)
+{
+    solution_t best = { 0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, MAXFLOAT };
+    double limit = min_CT + (CT_TOLERANCE * fabs(min_CT));
+    segment_t seg = { 0, 0, 0, 0 };
+
+    while (nextSegment(tiers, D * 2, &seg))
+    {
+        float ca = (tiers->ca_list[seg.i]).value;
+        float ce = (tiers->ce_list[seg.j]).value;
+        float cp = tiers->cp_percentage * ca;
+        int q = segmentOptimalQ(D, tiers, &seg);
+
+        METRIC_ADD(segments, 1);
+
+        if (modelCT(D, q, ca, ce, cp) > limit)
+        {
+            METRIC_ADD(pruned, 1);
+            continue;
+        }
+
+        int first = q;
+        int last = q;
+
+        while ((first > seg.lo) && (modelCT(D, first - 1, ca, ce, cp) <= limit))
+        {
+            first--;
+        }
+
+        while ((last < seg.hi) && (modelCT(D, last + 1, ca, ce, cp) <= limit))
+        {
+            last++;
+        }
+
+        METRIC_ADD(candidates, last - first + 1);
+
+        for (int i = first; i <= last; i++)
+        {
+            solution_t s = evaluateQ(D, i, ca, ce, tiers->cp_percentage);
+
+            // If the calculated CT is less than min_CT, update the values
+            if (s.CT < best.CT)
+            {
+                best = s;
+            }
+        }
+    }
+
+    return best;
+
+}   /* windowOptimalQ() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that calculates the Q* of a reference given a specific
+ *         Annual Demand (D) without scanning every Q from 1 to 2·D.
+ *         The ca_list/ce_list breakpoints split [1, 2·D] into segments
+ *         with fixed tiers, and each segment is solved in closed form.
+ *
+ *         The result is exactly the one of the exhaustive scan, which
+ *         keeps the first Q with the lowest float CT. Near the optimum
+ *         the float CT is flat to its last bit, so that Q is not the one
+ *         of the exact CT: after the closed-form pass, windowOptimalQ()
+ *         evaluates in float every Q that can still win. A solve costs
+ *         O(tiers + W), where the window W of Q evaluated grows about
+ *         as D^0.75: a handful of Q up to some thousands of units of
+ *         demand, a few hundred at D = 10^5, about 10^4 at D = 10^7.
+ * @param  D  This number indicates the annual demand for the reference.
+ * @param  tiers  Tiers of the reference.
+ * @return Costs of the optimal order (Q = 0 if D is not positive).
+ */
+inline solution_t solveOptimalQ(int D, const tiers_t * tiers)
+{
+    solution_t best = { 0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, MAXFLOAT };
+
+    METRIC_SOLVE();
+
+    if ((D <= 0) || (tiers->ca_count == 0) || (tiers->ce_count == 0))
+    {
+        return best;
+    }
+
+    segment_t seg;
+    int Q;
+
+    return windowOptimalQ(D, tiers, modelOptimum(D, tiers, &seg, &Q));
+
+}   /* solveOptimalQ() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that calculates the Q* of a reference given a specific
+ *         Annual Demand (D), see solveOptimalQ(int, const tiers_t *).
+ * @param  D  This number indicates the annual demand for the reference.
+ * @param  item  Pointer to reference.
+ * @return Costs of the optimal order (Q = 0 if D is not positive).
+ */
+inline solution_t solveOptimalQ(int D, const reference_t * item)
+{
+    tiers_t tiers = tiersOf(item);
+
+    return solveOptimalQ(D, &tiers);
+
+}   /* solveOptimalQ() */
+
+#endif /* EOQ_H */
+
+/*** end of file ***/
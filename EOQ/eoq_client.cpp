@@ -0,0 +1,172 @@
+/**
+ * @file     eoq_client.cpp
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Client of the Q* daemon (optimalQ --serve SOCKET). It sends
+ *           one request given in the command line, or every "ID,D" line
+ *           of stdin (pipelined, without waiting for each answer), and
+ *           prints the responses in order.
+ *
+ *           Build: g++ -O2 eoq_client.cpp -o eoq_client
+ *           Usage: ./eoq_client SOCKET [ID D] < demands.csv
+ */
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that connects to the daemon.
+ * @param  path  Path of the Unix domain socket.
+ * @return Socket, or -1 if the connection failed.
+ */
+static int connectDaemon(const char * path)
+{
+    struct sockaddr_un address;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+
+    if ((fd < 0) ||
+        (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0))
+    {
+        fprintf(stderr, " -> No se puede conectar a '%s': %s.\n", path,
+                strerror(errno));
+        return -1;
+    }
+
+    return fd;
+
+}   /* connectDaemon() */
+
+/******************************************************************************/
+/*!
+ * @brief  Main program of the client.
+ * @param  argc  Number of command line arguments.
+ * @param  argv  Socket, and optionally the ID and the demand.
+ * @return 0 on success, 1 on error.
+ */
+int main(int argc, char * argv[])
+{
+    if ((argc != 2) && (argc != 4))
+    {
+        fprintf(stderr, "Uso: %s SOCKET [ID DEMANDA]\n", argv[0]);
+        return 1;
+    }
+
+    int fd = connectDaemon(argv[1]);
+
+    if (fd < 0)
+    {
+        return 1;
+    }
+
+    string out;
+    char block[1 << 16];
+    bool input = (argc == 2);
+    bool sent = false;
+
+    if (argc == 4)
+    {
+        out = string(argv[2]) + "," + argv[3] + "\n";
+    }
+
+    // Send stdin and print the answers at the same time, so a long
+    // input never blocks on a full socket buffer
+    for (;;)
+    {
+        struct pollfd fds[2];
+        int count = 1;
+
+        // Everything is sent: tell the daemon, then drain the answers
+        if (out.empty() && (input == false) && (sent == false))
+        {
+            shutdown(fd, SHUT_WR);
+            sent = true;
+        }
+
+        fds[0].fd = fd;
+        fds[0].events = POLLIN | (out.empty() ? 0 : POLLOUT);
+        fds[0].revents = 0;
+
+        // Read more of stdin only when the previous block is sent
+        if (input && out.empty())
+        {
+            fds[1].fd = STDIN_FILENO;
+            fds[1].events = POLLIN;
+            fds[1].revents = 0;
+            count = 2;
+        }
+
+        if (poll(fds, count, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+
+        if (fds[0].revents & (POLLIN | POLLHUP | POLLERR))
+        {
+            ssize_t n = read(fd, block, sizeof(block));
+
+            if (n <= 0)
+            {
+                break;
+            }
+
+            fwrite(block, 1, n, stdout);
+        }
+
+        if ((fds[0].revents & POLLOUT) && (out.empty() == false))
+        {
+            ssize_t n = send(fd, out.data(), out.size(), MSG_NOSIGNAL);
+
+            if (n < 0)
+            {
+                break;
+            }
+
+            out.erase(0, n);
+        }
+
+        if ((count > 1) && (fds[1].revents & (POLLIN | POLLHUP)))
+        {
+            ssize_t n = read(STDIN_FILENO, block, sizeof(block));
+
+            if (n <= 0)
+            {
+                input = false;
+            }
+            else
+            {
+                out.append(block, n);
+            }
+        }
+    }
+
+    fflush(stdout);
+    close(fd);
+
+    return 0;
+
+}   /* main() */
+
+/*** end of file ***/
@@ -0,0 +1,246 @@
+/**
+ * @file     eoq_loadgen.cpp
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Load generator for the Q* daemon (optimalQ --serve SOCKET).
+ *           It opens several connections, keeps up to 'depth' requests
+ *           in flight on each one (pipelining) with the references of
+ *           references.h and pseudo-random demands, and measures the
+ *           latency of every request. The summary is a CSV row with the
+ *           throughput and the p50/p99/p99.9/max latencies.
+ *
+ *           Build: g++ -O2 eoq_loadgen.cpp -o eoq_loadgen
+ *           Usage: ./eoq_loadgen SOCKET [requests] [connections] [depth]
+ */
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "references.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+//-----[ CONSTANTS ]----------------------------------------------------------//
+
+#define DEFAULT_REQUESTS    100000
+#define DEFAULT_CONNECTIONS 4
+#define DEFAULT_DEPTH       16
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef chrono::steady_clock::time_point instant_t;
+
+typedef struct
+{
+    int fd;
+    string in;                  // Part of a response not finished yet
+    deque<instant_t> pending;   // Send time of each request in flight
+
+} client_t;
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that connects to the daemon.
+ * @param  path  Path of the Unix domain socket.
+ * @return Socket, or -1 if the connection failed.
+ */
+static int connectDaemon(const char * path)
+{
+    struct sockaddr_un address;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+
+    if ((fd < 0) ||
+        (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0))
+    {
+        fprintf(stderr, " -> No se puede conectar a '%s': %s.\n", path,
+                strerror(errno));
+        return -1;
+    }
+
+    return fd;
+
+}   /* connectDaemon() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that gets a percentile of the sorted latencies.
+ * @param  latencies  Latencies in microseconds, sorted.
+ * @param  p  Percentile, between 0 and 1.
+ * @return Latency of the percentile.
+ */
+static double percentile(const vector<double> & latencies, double p)
+{
+    if (latencies.empty())
+    {
+        return 0.0;
+    }
+
+    size_t i = (size_t)(p * (latencies.size() - 1) + 0.5);
+
+    return latencies[i];
+
+}   /* percentile() */
+
+/******************************************************************************/
+/*!
+ * @brief  Main program of the load generator.
+ * @param  argc  Number of command line arguments.
+ * @param  argv  Socket, requests, connections and depth.
+ * @return 0 on success, 1 on error.
+ */
+int main(int argc, char * argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Uso: %s SOCKET [peticiones] [conexiones] "
+                        "[profundidad]\n", argv[0]);
+        return 1;
+    }
+
+    long requests = (argc > 2) ? atol(argv[2]) : DEFAULT_REQUESTS;
+    int connections = (argc > 3) ? atoi(argv[3]) : DEFAULT_CONNECTIONS;
+    int depth = (argc > 4) ? atoi(argv[4]) : DEFAULT_DEPTH;
+
+    vector<client_t> clients(max(connections, 1));
+
+    for (size_t c = 0; c < clients.size(); c++)
+    {
+        clients[c].fd = connectDaemon(argv[1]);
+
+        if (clients[c].fd < 0)
+        {
+            return 1;
+        }
+    }
+
+    vector<double> latencies;
+    vector<struct pollfd> fds(clients.size());
+    long sent = 0;
+    long errors = 0;
+    unsigned int seed = 12345;
+    char block[1 << 16];
+
+    latencies.reserve(requests);
+    instant_t start = chrono::steady_clock::now();
+
+    while ((long)latencies.size() < requests)
+    {
+        // Top up every connection to 'depth' requests in flight
+        for (size_t c = 0; c < clients.size(); c++)
+        {
+            string out;
+
+            while ((sent < requests) &&
+                   ((int)clients[c].pending.size() < max(depth, 1)))
+            {
+                seed = seed * 1103515245 + 12345;
+                const reference_t * item = R_ALL[(seed >> 8) % R_ALL_COUNT];
+                int D = 1 + (int)((seed >> 4) % 100000);
+
+                out += item->id + "," + to_string(D) + "\n";
+                clients[c].pending.push_back(chrono::steady_clock::now());
+                sent++;
+            }
+
+            if (out.empty() == false)
+            {
+                // Requests are short, so the socket buffer takes them all
+                if (send(clients[c].fd, out.data(), out.size(), MSG_NOSIGNAL)
+                    != (ssize_t)out.size())
+                {
+                    fprintf(stderr, " -> Error al enviar: %s.\n",
+                            strerror(errno));
+                    return 1;
+                }
+            }
+
+            fds[c].fd = clients[c].fd;
+            fds[c].events = POLLIN;
+            fds[c].revents = 0;
+        }
+
+        if (poll(fds.data(), fds.size(), -1) < 0)
+        {
+            continue;
+        }
+
+        // Match every complete response with the oldest request in flight
+        for (size_t c = 0; c < clients.size(); c++)
+        {
+            if ((fds[c].revents & (POLLIN | POLLHUP | POLLERR)) == 0)
+            {
+                continue;
+            }
+
+            ssize_t n = read(clients[c].fd, block, sizeof(block));
+
+            if (n <= 0)
+            {
+                fprintf(stderr, " -> El daemon ha cerrado la conexión.\n");
+                return 1;
+            }
+
+            instant_t now = chrono::steady_clock::now();
+            size_t first = 0;
+            size_t end;
+
+            clients[c].in.append(block, n);
+
+            while ((end = clients[c].in.find('\n', first)) != string::npos)
+            {
+                chrono::duration<double, micro> latency;
+                latency = now - clients[c].pending.front();
+
+                latencies.push_back(latency.count());
+                errors += (clients[c].in.compare(first, 3, "OK,") != 0);
+                clients[c].pending.pop_front();
+                first = end + 1;
+            }
+
+            clients[c].in.erase(0, first);
+        }
+    }
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    for (size_t c = 0; c < clients.size(); c++)
+    {
+        close(clients[c].fd);
+    }
+
+    sort(latencies.begin(), latencies.end());
+
+    printf("requests,connections,depth,errors,seconds,requests_per_second,");
+    printf("p50_us,p99_us,p999_us,max_us\n");
+    printf("%ld,%d,%d,%ld,%.3f,%.0f,%.1f,%.1f,%.1f,%.1f\n", requests,
+           (int)clients.size(), depth, errors, elapsed.count(),
+           latencies.size() / elapsed.count(), percentile(latencies, 0.50),
+           percentile(latencies, 0.99), percentile(latencies, 0.999),
+           latencies.empty() ? 0.0 : latencies.back());
+
+    return (errors == 0) ? 0 : 1;
+
+}   /* main() */
+
+/*** end of file ***/
@@ -0,0 +1,342 @@
+/**
+ * @file     exhaustive.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Exhaustive scan of every Q from 1 to 2·D, as the original
+ *           showOptimalQ() did, for audits of the analytic solver.
+ *
+ *           The tiers are looked up once per segment (see nextSegment()),
+ *           not once per Q, and each segment is scanned with SIMD: the
+ *           Q of the lanes are consecutive, ce·D/Q and cp·Q/2 are taken
+ *           in double and rounded to float, and CT is added in float,
+ *           so every lane gives exactly the CT of evaluateQ(). Each lane
+ *           keeps its own minimum and the lanes are reduced at the end,
+ *           keeping the lowest Q on a tie as the original loop did.
+ *
+ *           The instruction set is picked at runtime (AVX-512, AVX2 or
+ *           plain scalar code), so the program is still built with a
+ *           plain g++ -O2.
+ */
+
+#ifndef EXHAUSTIVE_H
+#define EXHAUSTIVE_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "eoq.h"
+
+#include <math.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCAN_HAS_SIMD 1
+#else
+#define SCAN_HAS_SIMD 0
+#endif
+
+using namespace std;
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef enum
+{
+    SCAN_SCALAR,
+    SCAN_AVX2,      // 4 Q per instruction
+    SCAN_AVX512     // 8 Q per instruction
+
+} scan_isa_t;
+
+typedef struct
+{
+    int D;
+    float CA;       // ca·D, the same for the whole segment
+    float ce;
+    float cp;
+    float CT;       // Lowest CT found so far
+    int Q;          // Q of that CT
+
+} scan_state_t;
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that gets the widest instruction set of the processor
+ *         that the scan can use.
+ * @param  void
+ * @return Instruction set to pass to scanOptimalQ().
+ */
+inline scan_isa_t detectScanIsa(void)
+{
+#if SCAN_HAS_SIMD
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return SCAN_AVX512;
+    }
+
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return SCAN_AVX2;
+    }
+#endif
+
+    return SCAN_SCALAR;
+
+}   /* detectScanIsa() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that gets the name of an instruction set.
+ * @param  isa  Instruction set.
+ * @return Name of the instruction set.
+ */
+inline const char * scanIsaName(scan_isa_t isa)
+{
+    return (isa == SCAN_AVX512) ? "avx512" :
+           (isa == SCAN_AVX2) ? "avx2" : "scalar";
+
+}   /* scanIsaName() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that scans a range of Q one by one, with the same
+ *         arithmetic as evaluateQ().
+ * @param  state  Costs of the segment and minimum so far.
+ * @param  lo  First Q to scan.
+ * @param  hi  Last Q to scan.
+ * @return void
+ */
+inline void scanScalar(scan_state_t * state, int lo, int hi)
+{
+    for (int Q = lo; Q <= hi; Q++)
+    {
+        float CE = state->ce * ((state->D * 1.0) / (Q * 1.0));
+        float CP = state->cp * ((Q * 1.0) / 2.0);
+        float CT = state->CA + CE + CP;
+
+        if (CT < state->CT)
+        {
+            state->CT = CT;
+            state->Q = Q;
+        }
+    }
+
+}   /* scanScalar() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that merges the minimum of each lane into the state:
+ *         the lowest CT, and the lowest Q among equal CT.
+ * @param  state  Costs of the segment and minimum so far.
+ * @param  CT  Lowest CT of each lane.
+ * @param  Q  Q of the lowest CT of each lane.
+ * @param  lanes  Number of lanes.
+ * @return void
+ */
+inline void reduceLanes(scan_state_t * state, const float * CT, const int * Q,
+                        int lanes)
+{
+    for (int l = 0; l < lanes; l++)
+    {
+        if ((CT[l] < state->CT) || ((CT[l] == state->CT) && (Q[l] < state->Q)))
+        {
+            state->CT = CT[l];
+            state->Q = Q[l];
+        }
+    }
+
+}   /* reduceLanes() */
+
+#if SCAN_HAS_SIMD
+
+/******************************************************************************/
+/*!
+ * @brief  Method that scans a range of Q four at a time with AVX2.
+ * @param  state  Costs of the segment and minimum so far.
+ * @param  lo  First Q to scan.
+ * @param  hi  Last Q to scan.
+ * @return void
+ */
+__attribute__((target("avx2")))
+inline void scanAVX2(scan_state_t * state, int lo, int hi)
+{
+    if (hi - lo + 1 < 4)
+    {
+        scanScalar(state, lo, hi);
+        return;
+    }
+
+    const __m256d D = _mm256_set1_pd(state->D);
+    const __m256d ce = _mm256_set1_pd(state->ce);
+    const __m256d cp = _mm256_set1_pd(state->cp);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d step = _mm256_set1_pd(4.0);
+    const __m128i step_i = _mm_set1_epi32(4);
+    const __m128 CA = _mm_set1_ps(state->CA);
+
+    __m256d q = _mm256_setr_pd(lo, lo + 1.0, lo + 2.0, lo + 3.0);
+    __m128i q_i = _mm_setr_epi32(lo, lo + 1, lo + 2, lo + 3);
+    __m128 min_CT = _mm_set1_ps(MAXFLOAT);
+    __m128i min_Q = q_i;
+    int Q = lo;
+
+    for (; Q <= hi - 3; Q += 4)
+    {
+        __m128 CE = _mm256_cvtpd_ps(_mm256_mul_pd(ce, _mm256_div_pd(D, q)));
+        __m128 CP = _mm256_cvtpd_ps(_mm256_mul_pd(cp, _mm256_mul_pd(q, half)));
+        __m128 CT = _mm_add_ps(_mm_add_ps(CA, CE), CP);
+        __m128 lower = _mm_cmplt_ps(CT, min_CT);
+
+        min_CT = _mm_blendv_ps(min_CT, CT, lower);
+        min_Q = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(min_Q),
+                                               _mm_castsi128_ps(q_i), lower));
+        q = _mm256_add_pd(q, step);
+        q_i = _mm_add_epi32(q_i, step_i);
+    }
+
+    float lane_CT[4];
+    int lane_Q[4];
+
+    _mm_storeu_ps(lane_CT, min_CT);
+    _mm_storeu_si128((__m128i *)lane_Q, min_Q);
+    reduceLanes(state, lane_CT, lane_Q, 4);
+    scanScalar(state, Q, hi);
+
+}   /* scanAVX2() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that scans a range of Q eight at a time with AVX-512.
+ * @param  state  Costs of the segment and minimum so far.
+ * @param  lo  First Q to scan.
+ * @param  hi  Last Q to scan.
+ * @return void
+ */
+__attribute__((target("avx512f")))
+inline void scanAVX512(scan_state_t * state, int lo, int hi)
+{
+    if (hi - lo + 1 < 8)
+    {
+        scanScalar(state, lo, hi);
+        return;
+    }
+
+    const __m512d D = _mm512_set1_pd(state->D);
+    const __m512d ce = _mm512_set1_pd(state->ce);
+    const __m512d cp = _mm512_set1_pd(state->cp);
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __m512d step = _mm512_set1_pd(8.0);
+    const __m256i step_i = _mm256_set1_epi32(8);
+    const __m256 CA = _mm256_set1_ps(state->CA);
+
+    __m512d q = _mm512_add_pd(_mm512_set1_pd(lo),
+                              _mm512_setr_pd(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256i q_i = _mm256_add_epi32(_mm256_set1_epi32(lo),
+                                   _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256 min_CT = _mm256_set1_ps(MAXFLOAT);
+    __m256i min_Q = q_i;
+    int Q = lo;
+
+    for (; Q <= hi - 7; Q += 8)
+    {
+        __m256 CE = _mm512_maskz_cvtpd_ps(0xFF, _mm512_mul_pd(ce,
+                                          _mm512_div_pd(D, q)));
+        __m256 CP = _mm512_maskz_cvtpd_ps(0xFF, _mm512_mul_pd(cp,
+                                          _mm512_mul_pd(q, half)));
+        __m256 CT = _mm256_add_ps(_mm256_add_ps(CA, CE), CP);
+        __m256 lower = _mm256_cmp_ps(CT, min_CT, _CMP_LT_OQ);
+
+        min_CT = _mm256_blendv_ps(min_CT, CT, lower);
+        min_Q = _mm256_castps_si256(
+                    _mm256_blendv_ps(_mm256_castsi256_ps(min_Q),
+                                     _mm256_castsi256_ps(q_i), lower));
+        q = _mm512_add_pd(q, step);
+        q_i = _mm256_add_epi32(q_i, step_i);
+    }
+
+    float lane_CT[8];
+    int lane_Q[8];
+
+    _mm256_storeu_ps(lane_CT, min_CT);
+    _mm256_storeu_si256((__m256i *)lane_Q, min_Q);
+    reduceLanes(state, lane_CT, lane_Q, 8);
+    scanScalar(state, Q, hi);
+
+}   /* scanAVX512() */
+
+#endif /* SCAN_HAS_SIMD */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that calculates the Q* of a reference given a specific
+ *         Annual Demand (D) by evaluating every Q from 1 to 2·D. It gives
+ *         the same solution as solveOptimalQ(), bit for bit, and is
+ *         meant to check it.
+ * @param  D  This number indicates the annual demand for the reference.
+ * @param  tiers  Tiers of the reference.
+ * @param  isa  Instruction set (see detectScanIsa()).
+ * @return Costs of the optimal order (Q = 0 if D is not positive).
+ */
+inline solution_t scanOptimalQ(int D, const tiers_t * tiers, scan_isa_t isa)
+{
+    solution_t best = { 0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, MAXFLOAT };
+
+    METRIC_SOLVE();
+
+    if ((D <= 0) || (tiers->ca_count == 0) || (tiers->ce_count == 0))
+    {
+        return best;
+    }
+
+    scan_state_t state;
+    segment_t seg = { 0, 0, 0, 0 };
+
+    state.D = D;
+    state.CT = MAXFLOAT;
+    state.Q = 0;
+
+    while (nextSegment(tiers, D * 2, &seg))
+    {
+        float ca = (tiers->ca_list[seg.i]).value;
+
+        state.CA = ca * (D * 1.0);
+        state.ce = (tiers->ce_list[seg.j]).value;
+        state.cp = tiers->cp_percentage * ca;
+
+        METRIC_ADD(segments, 1);
+        METRIC_ADD(candidates, seg.hi - seg.lo + 1);
+
+#if SCAN_HAS_SIMD
+        if (isa == SCAN_AVX512)
+        {
+            scanAVX512(&state, seg.lo, seg.hi);
+            continue;
+        }
+
+        if (isa == SCAN_AVX2)
+        {
+            scanAVX2(&state, seg.lo, seg.hi);
+            continue;
+        }
+#endif
+
+        (void)isa;
+        scanScalar(&state, seg.lo, seg.hi);
+    }
+
+    if (state.Q > 0)
+    {
+        best = evaluateCT(D, state.Q, tiers);
+    }
+
+    return best;
+
+}   /* scanOptimalQ() */
+
+#endif /* EXHAUSTIVE_H */
+
+/*** end of file ***/
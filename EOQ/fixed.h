@@ -0,0 +1,280 @@
+/**
+ * @file     fixed.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Fixed-point variant of the Q* solver of eoq.h, for demands
+ *           beyond the int range and for results that must be the same
+ *           on every machine and compiler.
+ *
+ *           Prices are turned once into integer micro-units (1e-6 of
+ *           the currency) and everything else is integer arithmetic:
+ *           Q and D are 64-bit, and CT = ca·D + ce·D/Q + cp·Q/2 is kept
+ *           as the exact fraction (2·Q·ca·D + 2·ce·D + cp·Q²) / (2·Q)
+ *           in 128-bit integers. So the Q* is the true minimum of the
+ *           cost with those prices (the lowest Q on a tie), with no
+ *           rounding at all, and the costs are rounded half up only
+ *           when they are returned.
+ *
+ *             fixed_solution_t s;
+ *
+ *             if (solveOptimalQFixed(D, &tiers, &s)) ...
+ */
+
+#ifndef FIXED_H
+#define FIXED_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "types.h"
+#include "tiers.h"
+#include "metrics.h"
+
+#include <climits>
+#include <math.h>
+#include <stdint.h>
+
+using namespace std;
+
+//-----[ CONSTANTS ]----------------------------------------------------------//
+
+// Micro-units in one unit of currency
+#define FIXED_SCALE 1000000
+
+// Largest Annual Demand accepted (Q goes up to twice this)
+#define FIXED_MAX_DEMAND 1000000000000LL
+
+// Largest price, in micro-units, that keeps every product in 128 bits
+#define FIXED_MAX_PRICE (1000000LL * FIXED_SCALE)
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef __int128 wide_t;
+
+typedef struct
+{
+    int64_t Q;
+    int64_t ca;     // Prices and costs in micro-units
+    int64_t ce;
+    int64_t cp;
+    int64_t CA;
+    int64_t CE;
+    int64_t CP;
+    int64_t CT;
+
+} fixed_solution_t;
+
+typedef struct
+{
+    int i;          // Active tier of ca_list
+    int j;          // Active tier of ce_list
+    int64_t lo;     // First Q of the segment
+    int64_t hi;     // Last Q of the segment
+
+} fixed_segment_t;
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that turns a price of the catalog into micro-units.
+ * @param  value  Price in units of currency.
+ * @return Price in micro-units, rounded to the nearest one.
+ */
+inline int64_t fixedPrice(float value)
+{
+    return (int64_t)llround((double)value * FIXED_SCALE);
+
+}   /* fixedPrice() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that moves to the next range of Q in which both the
+ *         ca and the ce tiers stay fixed, as nextSegment() of eoq.h but
+ *         with 64-bit bounds. The first call must receive hi = 0.
+ * @param  tiers  Tiers of the reference.
+ * @param  Q_max  Last Q that is considered.
+ * @param  seg  Current segment, updated in place.
+ * @return false if there are no more segments below Q_max.
+ */
+inline bool nextFixedSegment(const tiers_t * tiers, int64_t Q_max,
+                             fixed_segment_t * seg)
+{
+    seg->lo = seg->hi + 1;
+
+    if (seg->lo > Q_max)
+    {
+        return false;
+    }
+
+    // Breakpoints are int, so any larger Q is in the last tier
+    int Q = (seg->lo > INT_MAX) ? INT_MAX : (int)seg->lo;
+
+    seg->i = findTier(tiers->ca_list, tiers->ca_count, Q);
+    seg->j = findTier(tiers->ce_list, tiers->ce_count, Q);
+    seg->hi = Q_max;
+
+    if ((seg->i + 1 < tiers->ca_count) &&
+        ((tiers->ca_list[seg->i + 1]).min_unit - 1 < seg->hi))
+    {
+        seg->hi = (tiers->ca_list[seg->i + 1]).min_unit - 1;
+    }
+
+    if ((seg->j + 1 < tiers->ce_count) &&
+        ((tiers->ce_list[seg->j + 1]).min_unit - 1 < seg->hi))
+    {
+        seg->hi = (tiers->ce_list[seg->j + 1]).min_unit - 1;
+    }
+
+    return true;
+
+}   /* nextFixedSegment() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that finds the best Q of a segment with fixed prices.
+ *         CT(Q) <= CT(Q + 1) exactly when 2·ce·D <= cp·Q·(Q + 1), so
+ *         the best Q is the first one that passes that test. It starts
+ *         at the continuous EOQ and is corrected with the exact test.
+ * @param  D  Annual demand for the reference.
+ * @param  ce  Cost of issue of the segment, in micro-units.
+ * @param  cp  Cost of ownership of the segment, in micro-units.
+ * @param  seg  Segment to minimise.
+ * @return Best Q of the segment (the lowest one on a tie).
+ */
+inline int64_t fixedSegmentQ(int64_t D, int64_t ce, int64_t cp,
+                             const fixed_segment_t * seg)
+{
+    if ((ce == 0) || (cp == 0))
+    {
+        // CT is monotonic: decreasing with no holding cost, else increasing
+        return ((ce > 0) && (cp == 0)) ? seg->hi : seg->lo;
+    }
+
+    wide_t twice_ceD = (wide_t)2 * ce * D;
+    double estimate = sqrt(2.0 * (double)ce * (double)D / (double)cp);
+    int64_t Q = (estimate > (double)seg->hi) ? seg->hi : (int64_t)estimate;
+
+    if (Q < seg->lo) Q = seg->lo;
+
+    while ((Q > seg->lo) && (twice_ceD <= (wide_t)cp * (Q - 1) * Q))
+    {
+        Q--;
+    }
+
+    while ((Q < seg->hi) && (twice_ceD > (wide_t)cp * Q * (Q + 1)))
+    {
+        Q++;
+    }
+
+    return Q;
+
+}   /* fixedSegmentQ() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that compares two costs given as fractions N / (2·Q),
+ *         with the integer part first and then the remainders, so no
+ *         product can overflow.
+ * @param  N1  Numerator of the first cost.
+ * @param  Q1  Q of the first cost.
+ * @param  N2  Numerator of the second cost.
+ * @param  Q2  Q of the second cost.
+ * @return true if the first cost is strictly lower.
+ */
+inline bool fixedLess(wide_t N1, int64_t Q1, wide_t N2, int64_t Q2)
+{
+    wide_t d1 = (wide_t)2 * Q1;
+    wide_t d2 = (wide_t)2 * Q2;
+
+    if (N1 / d1 != N2 / d2)
+    {
+        return (N1 / d1) < (N2 / d2);
+    }
+
+    return (N1 % d1) * d2 < (N2 % d2) * d1;
+
+}   /* fixedLess() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that calculates the Q* of a reference given a 64-bit
+ *         Annual Demand (D) in fixed point. Each segment with fixed
+ *         tiers is solved with fixedSegmentQ(), and the segments are
+ *         compared with their exact CT, so a solve costs O(tiers).
+ * @param  D  Annual demand for the reference (1 to FIXED_MAX_DEMAND).
+ * @param  tiers  Tiers of the reference.
+ * @param  best  Where the costs of the optimal order are stored.
+ * @return false if D or a price is out of range, or CT does not fit.
+ */
+inline bool solveOptimalQFixed(int64_t D, const tiers_t * tiers,
+                               fixed_solution_t * best)
+{
+    METRIC_SOLVE();
+
+    if ((D <= 0) || (D > FIXED_MAX_DEMAND) ||
+        (tiers->ca_count == 0) || (tiers->ce_count == 0))
+    {
+        return false;
+    }
+
+    int64_t percentage = fixedPrice(tiers->cp_percentage);
+    wide_t best_N = 0;
+    fixed_segment_t seg = { 0, 0, 0, 0 };
+
+    best->Q = 0;
+
+    while (nextFixedSegment(tiers, D * 2, &seg))
+    {
+        int64_t ca = fixedPrice((tiers->ca_list[seg.i]).value);
+        int64_t ce = fixedPrice((tiers->ce_list[seg.j]).value);
+
+        if ((ca < 0) || (ce < 0) || (percentage < 0) ||
+            (ca > FIXED_MAX_PRICE) || (ce > FIXED_MAX_PRICE) ||
+            (percentage > FIXED_MAX_PRICE))
+        {
+            return false;
+        }
+
+        // cp = ca·cp_percentage, rounded half up to a micro-unit
+        int64_t cp = (int64_t)(((wide_t)ca * percentage + FIXED_SCALE / 2) /
+                               FIXED_SCALE);
+        int64_t Q = fixedSegmentQ(D, ce, cp, &seg);
+
+        METRIC_ADD(segments, 1);
+        METRIC_ADD(candidates, 1);
+        wide_t N = (wide_t)2 * Q * ca * D + (wide_t)2 * ce * D +
+                   (wide_t)cp * Q * Q;
+
+        if ((best->Q == 0) || fixedLess(N, Q, best_N, best->Q))
+        {
+            best_N = N;
+            best->Q = Q;
+            best->ca = ca;
+            best->ce = ce;
+            best->cp = cp;
+        }
+    }
+
+    wide_t CT = (best_N + best->Q) / (2 * (wide_t)best->Q);
+
+    if (CT > INT64_MAX)
+    {
+        return false;
+    }
+
+    // Round each cost half up to a micro-unit
+    best->CA = best->ca * D;
+    best->CE = (int64_t)(((wide_t)2 * best->ce * D + best->Q) /
+                         (2 * (wide_t)best->Q));
+    best->CP = (int64_t)(((wide_t)best->cp * best->Q + 1) / 2);
+    best->CT = (int64_t)CT;
+
+    return true;
+
+}   /* solveOptimalQFixed() */
+
+#endif /* FIXED_H */
+
+/*** end of file ***/
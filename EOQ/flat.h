@@ -0,0 +1,205 @@
+/**
+ * @file     flat.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Flat layout of a catalog loaded from text, the one that the
+ *           batch, sweep and daemon modes solve from.
+ *
+ *           In catalog_t every reference_t keeps its own heap blocks
+ *           (two vectors of tiers and two strings), so solving the rows
+ *           of a big catalog follows a pointer per list. Here the layout
+ *           is the one of snapshot.h, in memory:
+ *
+ *             pool     Every tier of every reference, in one block.
+ *             records  Hot data: where the tiers of each reference are
+ *                      in the pool, and its cp_percentage (20 bytes).
+ *             texts    Cold data: where the ID and the description are
+ *                      in the string table, only read to print them.
+ *
+ *           Each block is allocated once, with its final size, so the
+ *           tiers of a reference are next to each other and next to the
+ *           tiers of the next one. A reference has the same position as
+ *           in catalog_t, so the ID index of the catalog is used as is.
+ *           The cost models (see policy.h) are only kept if some
+ *           reference does not use the original one.
+ */
+
+#ifndef FLAT_H
+#define FLAT_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "types.h"
+#include "catalog.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef struct
+{
+    uint32_t ca_offset;         // Into the pool
+    uint32_t ca_count;
+    uint32_t ce_offset;
+    uint32_t ce_count;
+    float cp_percentage;
+
+} flat_record_t;
+
+typedef struct
+{
+    uint32_t id_offset;         // Into the string table
+    uint32_t id_length;
+    uint32_t description_offset;
+    uint32_t description_length;
+
+} flat_text_t;
+
+typedef struct
+{
+    vector<cost_t> pool;            // Tiers of every reference
+    vector<flat_record_t> records;  // Hot data, one per reference
+    vector<flat_text_t> texts;      // Cold data, one per reference
+    string strings;                 // IDs and descriptions
+    vector<cost_model_t> models;    // Cost model of each reference, empty
+                                    // if all of them use the original one
+
+} flat_catalog_t;
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that builds the flat layout of a catalog.
+ * @param  catalog  Catalog of references.
+ * @param  flat  Where the flat layout is stored (its old content is lost).
+ * @return void
+ */
+inline void buildFlatCatalog(const catalog_t * catalog, flat_catalog_t * flat)
+{
+    const vector<reference_t> & references = catalog->references;
+    size_t tiers = 0;
+    size_t characters = 0;
+
+    for (const reference_t & item : references)
+    {
+        tiers += item.ca_list.size() + item.ce_list.size();
+        characters += item.id.size() + item.description.size();
+    }
+
+    // One allocation per block, with its final size
+    flat->pool.clear();
+    flat->pool.reserve(tiers);
+    flat->records.resize(references.size());
+    flat->texts.resize(references.size());
+    flat->strings.clear();
+    flat->strings.reserve(characters);
+
+    for (size_t i = 0; i < references.size(); i++)
+    {
+        const reference_t & item = references[i];
+        flat_record_t & record = flat->records[i];
+        flat_text_t & text = flat->texts[i];
+
+        record.ca_offset = (uint32_t)flat->pool.size();
+        record.ca_count = (uint32_t)item.ca_list.size();
+        flat->pool.insert(flat->pool.end(), item.ca_list.begin(),
+                          item.ca_list.end());
+
+        record.ce_offset = (uint32_t)flat->pool.size();
+        record.ce_count = (uint32_t)item.ce_list.size();
+        flat->pool.insert(flat->pool.end(), item.ce_list.begin(),
+                          item.ce_list.end());
+
+        record.cp_percentage = item.cp_percentage;
+
+        text.id_offset = (uint32_t)flat->strings.size();
+        text.id_length = (uint32_t)item.id.size();
+        flat->strings.append(item.id);
+
+        text.description_offset = (uint32_t)flat->strings.size();
+        text.description_length = (uint32_t)item.description.size();
+        flat->strings.append(item.description);
+    }
+
+    flat->models.clear();
+
+    for (size_t i = 0; i < references.size(); i++)
+    {
+        if (originalModel(&(references[i].model)) == false)
+        {
+            for (const reference_t & item : references)
+            {
+                flat->models.push_back(item.model);
+            }
+            break;
+        }
+    }
+
+}   /* buildFlatCatalog() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that gets the tiers of a reference of the flat layout
+ *         as a view for the solver.
+ * @param  flat  Flat layout of the catalog.
+ * @param  i  Position of the reference.
+ * @return View of the tiers (valid while the layout is alive).
+ */
+inline tiers_t flatTiers(const flat_catalog_t * flat, size_t i)
+{
+    const flat_record_t & record = flat->records[i];
+    tiers_t tiers;
+
+    tiers.ca_list = flat->pool.data() + record.ca_offset;
+    tiers.ca_count = (int)record.ca_count;
+    tiers.ce_list = flat->pool.data() + record.ce_offset;
+    tiers.ce_count = (int)record.ce_count;
+    tiers.cp_percentage = record.cp_percentage;
+    tiers.model = (flat->models).empty() ? NULL : &(flat->models[i]);
+
+    return tiers;
+
+}   /* flatTiers() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that gets the ID of a reference of the flat layout.
+ * @param  flat  Flat layout of the catalog.
+ * @param  i  Position of the reference.
+ * @return ID of the reference.
+ */
+inline string flatId(const flat_catalog_t * flat, size_t i)
+{
+    const flat_text_t & text = flat->texts[i];
+
+    return flat->strings.substr(text.id_offset, text.id_length);
+
+}   /* flatId() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that gets the description of a reference of the flat
+ *         layout.
+ * @param  flat  Flat layout of the catalog.
+ * @param  i  Position of the reference.
+ * @return Description of the reference.
+ */
+inline string flatDescription(const flat_catalog_t * flat, size_t i)
+{
+    const flat_text_t & text = flat->texts[i];
+
+    return flat->strings.substr(text.description_offset,
+                                text.description_length);
+
+}   /* flatDescription() */
+
+#endif /* FLAT_H */
+
+/*** end of file ***/
@@ -0,0 +1,446 @@
+/**
+ * @file     joint.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Joint replenishment of references that travel in the same
+ *           shipment (a jar with its lid and its box, for instance).
+ *
+ *           There is a shipment every base cycle of T years, and each
+ *           reference is ordered every k cycles, with k a power of two
+ *           (1, 2, 4, ... up to 2^JOINT_MAX_POWER) and at least one
+ *           k = 1. Power-of-two multipliers repeat every max(k) cycles
+ *           and lose at most about 2 % against any other multipliers
+ *           (Roundy, 1985). Each reference orders Q = D·k·T units
+ *           (rounded up, and k·T at most two years, so that Q <= 2·D as
+ *           in solveOptimalQ()) and pays its own CA and CP with the
+ *           tiers of that Q, while the issue cost is paid once per
+ *           shipment instead of once per reference: the highest ce
+ *           (each with the tier of its own Q) of the references that
+ *           the shipment carries.
+ *
+ *           The search goes over a geometric grid of T. For each T the
+ *           costs of every reference and power are tabulated once, and
+ *           the multipliers are improved one reference at a time; with
+ *           powers of two, the shipments of a period only depend on the
+ *           highest ce of each power, so each try costs O(n + powers).
+ *           A T whose lower bound (best CA + CP of each reference, plus
+ *           the cheapest issue cost every cycle) cannot beat the best
+ *           total so far is skipped, and the grid is refined around the
+ *           best T at the end.
+ */
+
+#ifndef JOINT_H
+#define JOINT_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "eoq.h"
+
+#include <algorithm>
+#include <climits>
+#include <math.h>
+#include <vector>
+
+using namespace std;
+
+//-----[ CONSTANTS ]----------------------------------------------------------//
+
+// Largest multiplier is 2^JOINT_MAX_POWER cycles
+#define JOINT_MAX_POWER 5
+
+// Ratio between two consecutive T of the grid, and of the refined grid
+#define JOINT_GRID_STEP   1.005
+#define JOINT_REFINE_STEP 1.0001
+
+// Passes over the references to improve the multipliers of one T
+#define JOINT_MAX_PASSES 4
+
+// Longest time between two orders of a reference, in years: its Q stays
+// in [1, 2·D], as in solveOptimalQ()
+#define JOINT_MAX_CYCLE 2.0
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef struct
+{
+    tiers_t tiers;
+    int D;          // Annual demand
+    int k;          // Cycles between two orders of the reference
+    int Q;          // Units of each order
+    float ca;       // Acquisition cost of the tier of Q
+    float ce;       // Cost of issue of the tier of Q
+    float cp;       // Cost of ownership of the tier of Q
+    double CA;      // Annual acquisition cost
+    double CP;      // Annual cost of ownership
+
+} joint_item_t;
+
+typedef struct
+{
+    double T;           // Base cycle, in years
+    double shipments;   // Shipments per year
+    double CE;          // Annual issue cost of the shipments
+    double CT;          // Annual total cost of the group
+
+} joint_solution_t;
+
+typedef struct
+{
+    double cost;    // Annual CA + CP of a reference with a multiplier
+    float ce;       // Cost of issue of its orders
+
+} joint_option_t;
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that gets the units of each order of a reference: the
+ *         demand of its k cycles, rounded up so that the orders cover
+ *         it (the issue cost of a shipment is paid once per cycle, so
+ *         rounding down would make it cheaper than it is). The relative
+ *         margin keeps T = Q/D on Q despite the rounding of D·T.
+ * @param  D  Annual demand.
+ * @param  k  Cycles between two orders (k·T up to JOINT_MAX_CYCLE).
+ * @param  T  Base cycle, in years.
+ * @return Units of each order (from 1 to 2·D).
+ */
+inline int jointQ(int D, int k, double T)
+{
+    double Q = ceil((double)D * k * T * (1.0 - 1e-12));
+
+    return (Q < 1.0) ? 1 : ((Q > 2.0 * D) ? 2 * D : (int)Q);
+
+}   /* jointQ() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that tabulates, for one T, the annual CA + CP and the
+ *         ce of every reference with every power of two. A power whose
+ *         orders would come more than JOINT_MAX_CYCLE years apart is
+ *         left out with an infinite cost.
+ * @param  items  References of the group.
+ * @param  T  Base cycle, in years.
+ * @param  options  Where the table is stored, JOINT_MAX_POWER + 1 per
+ *                  reference.
+ * @return void
+ */
+inline void fillOptions(const vector<joint_item_t> & items, double T,
+                        joint_option_t * options)
+{
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        for (int p = 0; p <= JOINT_MAX_POWER; p++)
+        {
+            joint_option_t & option = options[i * (JOINT_MAX_POWER + 1) + p];
+            int Q = jointQ(items[i].D, 1 << p, T);
+            float ca;
+
+            if ((1 << p) * T > JOINT_MAX_CYCLE)
+            {
+                option.cost = HUGE_VAL;
+                option.ce = 0.0f;
+                continue;
+            }
+
+            tierPrices(&(items[i].tiers), Q, &ca, &(option.ce));
+            option.cost = (ca * (double)items[i].D) +
+                          (items[i].tiers.cp_percentage * ca * (double)Q / 2.0);
+        }
+    }
+
+}   /* fillOptions() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that calculates the annual cost of the group for some
+ *         multipliers. Cycle c carries every reference whose power p has
+ *         2^p dividing c, so its shipment costs the highest ce among the
+ *         powers up to the number of times 2 divides c. Over a period of
+ *         2^P cycles there are 2^(P - v - 1) cycles where that number is
+ *         v, plus cycle 0, which carries every reference.
+ * @param  n  Number of references.
+ * @param  options  Table of fillOptions().
+ * @param  powers  Power of two of the multiplier of each reference.
+ * @param  T  Base cycle, in years.
+ * @param  CE  Where the annual issue cost is stored (can be NULL).
+ * @return Annual total cost.
+ */
+inline double groupCost(size_t n, const joint_option_t * options,
+                        const int * powers, double T, double * CE)
+{
+    float level[JOINT_MAX_POWER + 1] = { 0 };
+    double total = 0.0;
+    int P = 0;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        const joint_option_t & option =
+            options[i * (JOINT_MAX_POWER + 1) + powers[i]];
+
+        total += option.cost;
+        level[powers[i]] = max(level[powers[i]], option.ce);
+        P = max(P, powers[i]);
+    }
+
+    // Highest ce of the references in a cycle divisible by 2^v
+    double shipments = 0.0;
+    float ce = 0.0;
+
+    for (int v = 0; v <= P; v++)
+    {
+        ce = max(ce, level[v]);
+        shipments += ce * (double)((v < P) ? (1 << (P - v - 1)) : 1);
+    }
+
+    shipments /= (1 << P) * T;
+
+    if (CE != NULL)
+    {
+        *CE = shipments;
+    }
+
+    return total + shipments;
+
+}   /* groupCost() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that improves the multipliers of the group for one T,
+ *         trying every power of two for one reference at a time while
+ *         at least one reference keeps k = 1.
+ * @param  n  Number of references.
+ * @param  options  Table of fillOptions().
+ * @param  T  Base cycle, in years.
+ * @param  powers  Powers of the multipliers, updated in place.
+ * @return Annual total cost with the final multipliers.
+ */
+inline double improveMultipliers(size_t n, const joint_option_t * options,
+                                 double T, int * powers)
+{
+    double cost = groupCost(n, options, powers, T, NULL);
+    int ones = 0;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        ones += (powers[i] == 0);
+    }
+
+    for (int pass = 0; pass < JOINT_MAX_PASSES; pass++)
+    {
+        bool improved = false;
+
+        for (size_t i = 0; i < n; i++)
+        {
+            int current = powers[i];
+
+            // Some reference must go in every shipment
+            if ((current == 0) && (ones == 1))
+            {
+                continue;
+            }
+
+            for (int p = 0; p <= JOINT_MAX_POWER; p++)
+            {
+                if (p == current)
+                {
+                    continue;
+                }
+
+                powers[i] = p;
+                double candidate = groupCost(n, options, powers, T, NULL);
+
+                if (candidate < cost)
+                {
+                    ones += (p == 0) - (current == 0);
+                    cost = candidate;
+                    current = p;
+                    improved = true;
+                }
+            }
+
+            powers[i] = current;
+        }
+
+        if (improved == false)
+        {
+            break;
+        }
+    }
+
+    return cost;
+
+}   /* improveMultipliers() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that evaluates one T of the search: it skips it if its
+ *         lower bound cannot beat the best cost, and otherwise improves
+ *         the multipliers from the ones of each reference alone.
+ * @param  items  References of the group.
+ * @param  alone  Base cycle of each reference solved on its own.
+ * @param  ce_floor  Cheapest issue cost of any shipment.
+ * @param  T  Base cycle, in years.
+ * @param  options  Scratch table with room for every reference.
+ * @param  powers  Where the powers are stored if T is better.
+ * @param  best  Best annual total cost so far, updated if T is better.
+ * @param  bestT  Best base cycle so far, updated if T is better.
+ * @return void
+ */
+inline void tryCycle(const vector<joint_item_t> & items,
+                     const vector<double> & alone, double ce_floor, double T,
+                     joint_option_t * options, vector<int> * powers,
+                     double * best, double * bestT)
+{
+    size_t n = items.size();
+    vector<int> trial(n);
+    double bound = ce_floor / T;
+    size_t lowest = 0;
+
+    fillOptions(items, T, options);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        double item_min = HUGE_VAL;
+
+        for (int p = 0; p <= JOINT_MAX_POWER; p++)
+        {
+            item_min = min(item_min,
+                           options[i * (JOINT_MAX_POWER + 1) + p].cost);
+        }
+
+        bound += item_min;
+
+        // Start from the power of two closest to the cycle of i alone
+        int p = (int)floor(log2(max(alone[i] / T, 1.0)) + 0.5);
+
+        while ((p > 0) && ((1 << p) * T > JOINT_MAX_CYCLE))
+        {
+            p--;
+        }
+
+        trial[i] = min(p, JOINT_MAX_POWER);
+        lowest = (trial[i] < trial[lowest]) ? i : lowest;
+    }
+
+    if (bound >= *best)
+    {
+        return;
+    }
+
+    trial[lowest] = 0;
+
+    double cost = improveMultipliers(n, options, T, trial.data());
+
+    if (cost < *best)
+    {
+        *best = cost;
+        *bestT = T;
+        *powers = trial;
+    }
+
+}   /* tryCycle() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that finds the base cycle and the multipliers of a
+ *         group of references with the lowest annual total cost, and
+ *         fills in the order of each reference.
+ * @param  items  References of the group (D > 0), updated in place.
+ * @param  solution  Where the costs of the group are stored.
+ * @return false if the group is empty.
+ */
+inline bool solveJoint(vector<joint_item_t> * items,
+                       joint_solution_t * solution)
+{
+    size_t n = items->size();
+
+    if (n == 0)
+    {
+        return false;
+    }
+
+    // Cycle of each reference on its own, and the range of T to search
+    vector<double> alone(n);
+    double ce_floor = HUGE_VAL;
+    double T_min = HUGE_VAL;
+    double T_max = 0.0;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        const joint_item_t & item = (*items)[i];
+
+        alone[i] = solveOptimalQ(item.D, &(item.tiers)).Q / (double)item.D;
+        T_min = min(T_min, alone[i]);
+        T_max = max(T_max, alone[i]);
+
+        for (int j = 0; j < item.tiers.ce_count; j++)
+        {
+            ce_floor = min(ce_floor, (double)(item.tiers.ce_list[j]).value);
+        }
+    }
+
+    vector<joint_option_t> options(n * (JOINT_MAX_POWER + 1));
+    vector<int> powers(n, 0);
+    double best = HUGE_VAL;
+    double bestT = T_max;
+
+    ce_floor = max(ce_floor, 0.0);
+
+    // Coarse grid from a fraction of the shortest cycle to the longest
+    T_min /= (1 << JOINT_MAX_POWER);
+    T_max = min(T_max * 2.0, JOINT_MAX_CYCLE);
+
+    for (double T = T_min; T <= T_max; T *= JOINT_GRID_STEP)
+    {
+        tryCycle(*items, alone, ce_floor, T, options.data(), &powers, &best,
+                 &bestT);
+    }
+
+    // The cycles of each reference alone, where its Q* is exact
+    for (size_t i = 0; i < n; i++)
+    {
+        tryCycle(*items, alone, ce_floor, alone[i], options.data(), &powers,
+                 &best, &bestT);
+    }
+
+    // Finer grid between the neighbours of the best T
+    double T_end = min(bestT * JOINT_GRID_STEP, JOINT_MAX_CYCLE);
+
+    for (double T = bestT / JOINT_GRID_STEP; T <= T_end;
+         T *= JOINT_REFINE_STEP)
+    {
+        tryCycle(*items, alone, ce_floor, T, options.data(), &powers, &best,
+                 &bestT);
+    }
+
+    // Fill in the orders of the best solution
+    for (size_t i = 0; i < n; i++)
+    {
+        joint_item_t & item = (*items)[i];
+
+        item.k = 1 << powers[i];
+        item.Q = jointQ(item.D, item.k, bestT);
+        tierPrices(&(item.tiers), item.Q, &(item.ca), &(item.ce));
+        item.cp = item.tiers.cp_percentage * item.ca;
+        item.CA = item.ca * (double)item.D;
+        item.CP = item.cp * (double)item.Q / 2.0;
+    }
+
+    fillOptions(*items, bestT, options.data());
+
+    // Every cycle carries the references with k = 1
+    solution->T = bestT;
+    solution->shipments = 1.0 / bestT;
+    solution->CT = groupCost(n, options.data(), powers.data(), bestT,
+                             &(solution->CE));
+
+    return true;
+
+}   /* solveJoint() */
+
+#endif /* JOINT_H */
+
+/*** end of file ***/
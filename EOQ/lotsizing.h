@@ -0,0 +1,201 @@
+/**
+ * @file     lotsizing.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Time-phased lot sizing of a reference (Wagner and Whitin,
+ *           1958) with the tiered prices of the catalog: given the demand
+ *           of every period (months, weeks...), it chooses in which
+ *           periods to order and how much, so that the acquisition cost
+ *           (ca of the tier of each order), the issue cost (ce of that
+ *           tier, once per order) and the cost of ownership (cp of that
+ *           tier, per unit and year in stock) add up to the minimum.
+ *
+ *           Each order covers the demand of whole consecutive periods
+ *           and arrives when the stock runs out (zero-inventory
+ *           ordering), and the stock is charged at the end of each
+ *           period, so the demand of period k ordered in period i stays
+ *           k - i periods. The dynamic program is
+ *
+ *             f(j) = min over i <= j of f(i) + cost(order in i for i..j)
+ *
+ *           where f(j) is the cost of the periods before j. The states
+ *           are pruned with a bound: every unit costs at least the
+ *           cheapest ca, and carrying the demand of i..j from i costs at
+ *           least the cheapest cp. That bound only grows as i moves back,
+ *           so once it reaches the best cost of j no earlier order period
+ *           can win, and the scan stops (the planning horizon of the
+ *           seasonal peaks).
+ */
+
+#ifndef LOTSIZING_H
+#define LOTSIZING_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "eoq.h"
+
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef struct
+{
+    int period;     // Period of the order (from 0)
+    int periods;    // Periods that it covers
+    int Q;          // Units of the order
+    float ca;       // Acquisition cost of the tier of Q
+    float ce;       // Cost of issue of the tier of Q
+    float cp;       // Cost of ownership of the tier of Q
+    double cost;    // CA + CE + CP of the order
+
+} lot_order_t;
+
+typedef struct
+{
+    vector<lot_order_t> orders;
+    double CT;              // Cost of the whole horizon
+    uint64_t evaluated;     // Orders whose cost was computed
+
+} lot_plan_t;
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that computes the costs of an order that covers some
+ *         consecutive periods.
+ * @param  tiers  Tiers of the reference.
+ * @param  Q  Units of the order (at least 1).
+ * @param  carried  Units · periods that the order keeps in stock.
+ * @param  periodsPerYear  Periods of a year.
+ * @param  order  Where the prices and the cost of the order are stored.
+ * @return void
+ */
+inline void lotCost(const tiers_t * tiers, int Q, int64_t carried,
+                    int periodsPerYear, lot_order_t * order)
+{
+    tierPrices(tiers, Q, &(order->ca), &(order->ce));
+
+    order->Q = Q;
+    order->cp = tiers->cp_percentage * order->ca;
+    order->cost = order->ca * (Q * 1.0) + order->ce +
+                  order->cp * ((double)carried / periodsPerYear);
+
+}   /* lotCost() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that finds the plan of orders with the lowest cost for
+ *         the demands of a horizon of periods (see the top of the file).
+ * @param  tiers  Tiers of the reference.
+ * @param  demand  Units of each period (0 or more, adding up to at most
+ *                 INT_MAX).
+ * @param  periodsPerYear  Periods of a year (12 months, 52 weeks...).
+ * @param  plan  Where the orders, in period order, are stored.
+ * @return void
+ */
+inline void solveLotSizing(const tiers_t * tiers, const vector<int> & demand,
+                           int periodsPerYear, lot_plan_t * plan)
+{
+    size_t T = demand.size();
+    vector<int64_t> units(T + 1, 0);    // Units of the periods before k
+    vector<int64_t> moment(T + 1, 0);   // Sum of d·k of the periods before k
+    vector<double> best(T + 1, 0.0);    // f(k)
+    vector<lot_order_t> last(T + 1);    // Last order of the plan of f(k)
+    float caMin = tiers->ca_list[0].value;
+    float ceMin = tiers->ce_list[0].value;
+
+    for (int t = 1; t < tiers->ca_count; t++)
+    {
+        caMin = min(caMin, tiers->ca_list[t].value);
+    }
+
+    for (int t = 1; t < tiers->ce_count; t++)
+    {
+        ceMin = min(ceMin, tiers->ce_list[t].value);
+    }
+
+    double cpMin = tiers->cp_percentage * caMin / periodsPerYear;
+
+    for (size_t k = 0; k < T; k++)
+    {
+        units[k + 1] = units[k] + demand[k];
+        moment[k + 1] = moment[k] + (int64_t)demand[k] * k;
+    }
+
+    plan->evaluated = 0;
+
+    for (size_t j = 0; j < T; j++)
+    {
+        // A period with no demand needs no order of its own
+        best[j + 1] = best[j];
+        last[j + 1] = { (int)j, 1, 0, 0.0f, 0.0f, 0.0f, 0.0 };
+
+        if (demand[j] == 0)
+        {
+            continue;
+        }
+
+        best[j + 1] = -1.0;
+
+        for (size_t i = j + 1; i-- > 0; )
+        {
+            int64_t Q = units[j + 1] - units[i];
+            int64_t carried = (moment[j + 1] - moment[i]) - Q * (int64_t)i;
+            double bound = caMin * (double)units[j + 1] + ceMin +
+                           cpMin * (double)carried;
+
+            // Earlier periods only carry more: none of them can win
+            if ((best[j + 1] >= 0.0) && (bound >= best[j + 1]))
+            {
+                break;
+            }
+
+            // Nor this one if its own plan is already too expensive
+            if ((best[j + 1] >= 0.0) &&
+                (best[i] + caMin * (double)Q + ceMin +
+                 cpMin * (double)carried >= best[j + 1]))
+            {
+                continue;
+            }
+
+            lot_order_t order;
+
+            lotCost(tiers, (int)Q, carried, periodsPerYear, &order);
+            plan->evaluated++;
+
+            if ((best[j + 1] < 0.0) || (best[i] + order.cost < best[j + 1]))
+            {
+                order.period = (int)i;
+                order.periods = (int)(j + 1 - i);
+                best[j + 1] = best[i] + order.cost;
+                last[j + 1] = order;
+            }
+        }
+    }
+
+    // Follow the last orders back from the end of the horizon
+    plan->orders.clear();
+    plan->CT = best[T];
+
+    for (size_t k = T; k > 0; k -= last[k].periods)
+    {
+        if (last[k].Q > 0)
+        {
+            plan->orders.push_back(last[k]);
+        }
+    }
+
+    reverse(plan->orders.begin(), plan->orders.end());
+
+}   /* solveLotSizing() */
+
+#endif /* LOTSIZING_H */
+
+/*** end of file ***/
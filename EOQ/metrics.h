@@ -0,0 +1,365 @@
+/**
+ * @file     metrics.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Counters of the work that every solve does, to find out why a
+ *           planning run is slow. Built with -DEOQ_METRICS, each solve
+ *           counts
+ *
+ *             candidates  Q evaluated in float (see solveOptimalQ()).
+ *             probes      Tier lookups (see findTier()).
+ *             segments    Segments with fixed tiers that were visited.
+ *             pruned      Segments skipped because their exact CT could
+ *                         not reach the minimum.
+ *
+ *           and its wall time. The totals and the histograms of time and
+ *           candidates per solve are kept per thread, with no locks, and
+ *           added to the global ones when the thread ends. They are
+ *           exported as JSON or as Prometheus text (exportMetrics()).
+ *
+ *           Without -DEOQ_METRICS the macros are empty and nothing of
+ *           this is compiled into the solvers; exportMetrics() only
+ *           reports that the metrics are not available.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include <string>
+
+#ifdef EOQ_METRICS
+#include <chrono>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#endif
+
+using namespace std;
+
+#ifdef EOQ_METRICS
+
+//-----[ CONSTANTS ]----------------------------------------------------------//
+
+// Buckets of each histogram, the last one without upper bound
+#define METRICS_BUCKETS 18
+
+// Upper bound of the first bucket of the time histogram, in ns
+#define METRICS_FIRST_NS 64
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef struct
+{
+    uint64_t candidates;
+    uint64_t probes;
+    uint64_t segments;
+    uint64_t pruned;
+
+} metrics_counts_t;
+
+typedef struct
+{
+    uint64_t solves;
+    metrics_counts_t counts;
+    uint64_t wall_ns;
+    uint64_t wall_histogram[METRICS_BUCKETS];       // <= 64 ns · 2^b
+    uint64_t candidate_histogram[METRICS_BUCKETS];  // <= 2^b candidates
+
+} metrics_t;
+
+// Metrics of one thread, added to the global ones when the thread ends
+struct metrics_thread_t
+{
+    metrics_t totals;
+    metrics_counts_t solve;     // Counts of the solve in progress
+    int depth;                  // Nested solves (only the outer one counts)
+
+    ~metrics_thread_t();
+};
+
+//-----[ GLOBALS ]------------------------------------------------------------//
+
+inline metrics_t g_metrics = {};
+inline mutex g_metrics_lock;
+inline thread_local metrics_thread_t t_metrics = {};
+
+//-----[ MACROS ]-------------------------------------------------------------//
+
+// Adds n to a counter of the solve in progress
+#define METRIC_ADD(counter, n) (t_metrics.solve.counter += (n))
+
+// Times and counts the enclosing block as one solve
+#define METRIC_SOLVE() metrics_scope_t metrics_scope_
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that adds some metrics to others.
+ * @param  total  Metrics that receive the sum.
+ * @param  part  Metrics to add.
+ * @return void
+ */
+inline void addMetrics(metrics_t * total, const metrics_t * part)
+{
+    total->solves += part->solves;
+    total->counts.candidates += part->counts.candidates;
+    total->counts.probes += part->counts.probes;
+    total->counts.segments += part->counts.segments;
+    total->counts.pruned += part->counts.pruned;
+    total->wall_ns += part->wall_ns;
+
+    for (int b = 0; b < METRICS_BUCKETS; b++)
+    {
+        total->wall_histogram[b] += part->wall_histogram[b];
+        total->candidate_histogram[b] += part->candidate_histogram[b];
+    }
+
+}   /* addMetrics() */
+
+inline metrics_thread_t::~metrics_thread_t()
+{
+    lock_guard<mutex> guard(g_metrics_lock);
+
+    addMetrics(&g_metrics, &totals);
+
+}   /* ~metrics_thread_t() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that finds the bucket of a histogram for a value: the
+ *         first one whose upper bound (first · 2^b) is not below it.
+ * @param  value  Value to count.
+ * @param  first  Upper bound of the first bucket.
+ * @return Bucket of the value.
+ */
+inline int metricsBucket(uint64_t value, uint64_t first)
+{
+    int b = 0;
+
+    while ((b < METRICS_BUCKETS - 1) && (value > (first << b)))
+    {
+        b++;
+    }
+
+    return b;
+
+}   /* metricsBucket() */
+
+// Block that is timed and counted as one solve (see METRIC_SOLVE())
+struct metrics_scope_t
+{
+    chrono::steady_clock::time_point start;
+
+    metrics_scope_t()
+    {
+        if (t_metrics.depth++ == 0)
+        {
+            t_metrics.solve = {};
+            start = chrono::steady_clock::now();
+        }
+    }
+
+    ~metrics_scope_t()
+    {
+        if (--t_metrics.depth > 0)
+        {
+            return;
+        }
+
+        metrics_t & totals = t_metrics.totals;
+        const metrics_counts_t & solve = t_metrics.solve;
+        uint64_t ns = chrono::duration_cast<chrono::nanoseconds>(
+                          chrono::steady_clock::now() - start).count();
+
+        totals.solves++;
+        totals.counts.candidates += solve.candidates;
+        totals.counts.probes += solve.probes;
+        totals.counts.segments += solve.segments;
+        totals.counts.pruned += solve.pruned;
+        totals.wall_ns += ns;
+        totals.wall_histogram[metricsBucket(ns, METRICS_FIRST_NS)]++;
+        totals.candidate_histogram[metricsBucket(solve.candidates, 1)]++;
+    }
+};
+
+/******************************************************************************/
+/*!
+ * @brief  Method that adds a histogram to a JSON object, as the upper
+ *         bounds of its buckets and the count of each one.
+ * @param  out  Text that receives the histogram.
+ * @param  name  Name of the histogram.
+ * @param  histogram  Count of each bucket.
+ * @param  first  Upper bound of the first bucket.
+ * @return void
+ */
+inline void jsonHistogram(string * out, const char * name,
+                          const uint64_t * histogram, uint64_t first)
+{
+    *out += string(",\"") + name + "\":{\"le\":[";
+
+    for (int b = 0; b < METRICS_BUCKETS - 1; b++)
+    {
+        *out += ((b > 0) ? "," : "") + to_string(first << b);
+    }
+
+    *out += ",null],\"count\":[";
+
+    for (int b = 0; b < METRICS_BUCKETS; b++)
+    {
+        *out += ((b > 0) ? "," : "") + to_string(histogram[b]);
+    }
+
+    *out += "]}";
+
+}   /* jsonHistogram() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that adds a histogram in the Prometheus text format,
+ *         with cumulative buckets.
+ * @param  out  Text that receives the histogram.
+ * @param  name  Name of the metric.
+ * @param  help  Description of the metric.
+ * @param  histogram  Count of each bucket.
+ * @param  first  Upper bound of the first bucket.
+ * @param  scale  Factor from the bounds to the unit of the metric.
+ * @param  sum  Sum of every value, in the unit of the metric.
+ * @param  count  Number of values.
+ * @return void
+ */
+inline void prometheusHistogram(string * out, const char * name,
+                                const char * help, const uint64_t * histogram,
+                                uint64_t first, double scale, double sum,
+                                uint64_t count)
+{
+    char text[64];
+    uint64_t cumulative = 0;
+
+    *out += string("# HELP ") + name + " " + help + "\n";
+    *out += string("# TYPE ") + name + " histogram\n";
+
+    for (int b = 0; b < METRICS_BUCKETS; b++)
+    {
+        cumulative += histogram[b];
+
+        if (b < METRICS_BUCKETS - 1)
+        {
+            snprintf(text, sizeof(text), "%g", (double)(first << b) * scale);
+        }
+        else
+        {
+            strcpy(text, "+Inf");
+        }
+
+        *out += string(name) + "_bucket{le=\"" + text + "\"} ";
+        *out += to_string(cumulative) + "\n";
+    }
+
+    snprintf(text, sizeof(text), "%.9g", sum);
+    *out += string(name) + "_sum " + text + "\n";
+    *out += string(name) + "_count " + to_string(count) + "\n";
+
+}   /* prometheusHistogram() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that exports the metrics of the threads that have ended
+ *         and of the calling thread.
+ * @param  format  "json" (one line) or "prometheus".
+ * @param  out  Text that receives the metrics.
+ * @return false if the format is not known.
+ */
+inline bool exportMetrics(const string & format, string * out)
+{
+    metrics_t m = t_metrics.totals;
+
+    {
+        lock_guard<mutex> guard(g_metrics_lock);
+
+        addMetrics(&m, &g_metrics);
+    }
+
+    if (format == "json")
+    {
+        *out += "{\"solves\":" + to_string(m.solves);
+        *out += ",\"candidates\":" + to_string(m.counts.candidates);
+        *out += ",\"tier_probes\":" + to_string(m.counts.probes);
+        *out += ",\"segments\":" + to_string(m.counts.segments);
+        *out += ",\"segments_pruned\":" + to_string(m.counts.pruned);
+        *out += ",\"wall_ns\":" + to_string(m.wall_ns);
+        jsonHistogram(out, "wall_ns_histogram", m.wall_histogram,
+                      METRICS_FIRST_NS);
+        jsonHistogram(out, "candidates_histogram", m.candidate_histogram, 1);
+        *out += "}\n";
+        return true;
+    }
+
+    if (format == "prometheus")
+    {
+        const char * counters[4][2] =
+        {
+            { "eoq_candidates_total", "Q evaluated in float." },
+            { "eoq_tier_probes_total", "Tier lookups." },
+            { "eoq_segments_total", "Segments with fixed tiers visited." },
+            { "eoq_segments_pruned_total", "Segments skipped by their CT." }
+        };
+        uint64_t values[4] = { m.counts.candidates, m.counts.probes,
+                               m.counts.segments, m.counts.pruned };
+
+        *out += "# HELP eoq_solves_total Solves of Q*.\n";
+        *out += "# TYPE eoq_solves_total counter\n";
+        *out += "eoq_solves_total " + to_string(m.solves) + "\n";
+
+        for (int c = 0; c < 4; c++)
+        {
+            *out += string("# HELP ") + counters[c][0] + " " + counters[c][1];
+            *out += string("\n# TYPE ") + counters[c][0] + " counter\n";
+            *out += string(counters[c][0]) + " " + to_string(values[c]) + "\n";
+        }
+
+        prometheusHistogram(out, "eoq_solve_seconds", "Wall time of a solve.",
+                            m.wall_histogram, METRICS_FIRST_NS, 1e-9,
+                            m.wall_ns * 1e-9, m.solves);
+        prometheusHistogram(out, "eoq_solve_candidates",
+                            "Q evaluated in float per solve.",
+                            m.candidate_histogram, 1, 1.0,
+                            (double)m.counts.candidates, m.solves);
+        return true;
+    }
+
+    return false;
+
+}   /* exportMetrics() */
+
+#else /* EOQ_METRICS */
+
+#define METRIC_ADD(counter, n) ((void)0)
+#define METRIC_SOLVE() ((void)0)
+
+/******************************************************************************/
+/*!
+ * @brief  Method that exports the metrics, which are not compiled in.
+ * @param  format  "json" or "prometheus".
+ * @param  out  Text that receives the metrics (left as it is).
+ * @return false always.
+ */
+inline bool exportMetrics(const string & format, string * out)
+{
+    (void)format;
+    (void)out;
+
+    return false;
+
+}   /* exportMetrics() */
+
+#endif /* EOQ_METRICS */
+
+#endif /* METRICS_H */
+
+/*** end of file ***/
@@ -5,171 +5,2537 @@
  * @date     November, 2024
  * @section  LIO-GIIROB
  * @brief    This program calculates the optimal Q given a demand D of the
- *           items defined in references.h
+ *           items defined in references.h (or in a catalog file, see
+ *           catalog.h)
+ *
+ *           Build: g++ -O2 -pthread optimalQ.cpp -o optimalQ
+ *
+ *           With -DEOQ_STATIC_CATALOG the built-in references are the
+ *           constexpr ones of catalog_static.h instead (see
+ *           static_catalog.h), looked up with no allocation at all.
+ *
+ *           Each reference is solved with the cost model that the
+ *           catalog gives it (see policy.h); the interactive, batch,
+ *           solve-all, daemon and BOM modes know every model, the rest
+ *           only the original one.
+ */
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#ifdef EOQ_STATIC_CATALOG
+#include "catalog_static.h"
+#else
+#include "references.h"
+#endif
+#include "eoq.h"
+#include "render.h"
+#include "catalog.h"
+#include "snapshot.h"
+#include "threadpool.h"
+#include "server.h"
+#include "cache.h"
+#include "sweep.h"
+#include "fixed.h"
+#include "exhaustive.h"
+#include "joint.h"
+#include "constrained.h"
+#include "static_catalog.h"
+#include "flat.h"
+#include "metrics.h"
+#include "stream.h"
+#include "simulate.h"
+#include "lotsizing.h"
+#include "bom.h"
+#include "curve.h"
+#include "suppliers.h"
+#include "policy.h"
+
+#include <iostream>
+#include <iomanip> // Para std::setw
+#include <math.h>
+#include <unordered_map>
+#include <vector>
+#include <limits> // Para std::numeric_limits
+#include <fstream>
+#include <climits>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+
+using namespace std;
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef enum
+{
+    SOLVER_SEGMENTS,    // solveModelQ() of policy.h
+    SOLVER_FIXED,       // solveOptimalQFixed() of fixed.h
+    SOLVER_EXHAUSTIVE   // scanOptimalQ() of exhaustive.h
+
+} solver_t;
+
+typedef struct
+{
+    const catalog_t * catalog;      // Catalog parsed from text, or NULL
+                                    // for catalog_static.h
+    const flat_catalog_t * flat;    // Flat layout of catalog (see flat.h)
+    const snapshot_t * snapshot;    // Catalog mapped from a snapshot, or NULL
+    uint64_t stamp;                 // catalogStamp() of the references
+    result_cache_t * cache;         // Cache of solutions, or NULL
+    solver_t solver;                // Solver of every request
+    scan_isa_t isa;                 // Instruction set of SOLVER_EXHAUSTIVE
+
+} source_t;
+
+typedef enum
+{
+    MODE_INTERACTIVE,
+    MODE_BATCH,
+    MODE_SOLVE_ALL,
+    MODE_SERVE,
+    MODE_SWEEP,
+    MODE_JOINT,
+    MODE_CONSTRAINED,
+    MODE_STREAM,
+    MODE_SIMULATE,
+    MODE_LOT_SIZING,
+    MODE_BOM,
+    MODE_CURVE,
+    MODE_SUPPLIERS
+
+} run_mode_t;
+
+//-----[ CONSTANTS ]----------------------------------------------------------//
+
+// Bytes of batch output that are gathered before each write to stdout
+#define BATCH_BUFFER_SIZE (1 << 16)
+
+// Rows that a thread solves each time it takes work in solve-all mode
+#define SOLVE_ALL_GRAIN 256
+
+// References that a thread plans each time it takes work in lot sizing
+#define LOT_SIZING_GRAIN 4
+
+// Rows that a thread solves each time it takes work in supplier mode
+#define SUPPLIERS_GRAIN 64
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that calculates the Q* of a reference given
+ *         a specific Annual Demand (D). It shows a table with
+ *         the values ​​of ce, ca, cp, Q*, CA, CE, CP and CT.
+ * @param  D  This number indicates the annual demand for the reference.
+ * @param  tiers  Tiers of the reference.
+ * @return void
+ */
+void showOptimalQ(int D, const tiers_t * tiers)
+{
+    showSolution(solveModelQ(D, tiers));
+
+}   /* showOptimalQ() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that finds the tiers of a reference by its ID in the
+ *         catalog, the snapshot or the constexpr catalog, whichever is
+ *         in use.
+ * @param  source  Catalog or snapshot of references.
+ * @param  id  ID of the reference.
+ * @param  tiers  Where the tiers of the reference are stored.
+ * @return false if the reference is not in the dictionary.
+ */
+static bool findTiers(const source_t * source, const string & id,
+                      tiers_t * tiers)
+{
+    if (source->snapshot != NULL)
+    {
+        long i = findSnapshotReference(source->snapshot, id.data(), id.size());
+
+        if (i < 0)
+        {
+            return false;
+        }
+
+        *tiers = snapshotTiers(source->snapshot, i);
+        return true;
+    }
+
+#ifdef EOQ_STATIC_CATALOG
+    if (source->catalog == NULL)
+    {
+        const static_reference_t * item = findStaticReference(
+                        STATIC_REFERENCES, STATIC_INDEX, id.data(), id.size());
+
+        if (item == NULL)
+        {
+            return false;
+        }
+
+        *tiers = staticTiers(item);
+        return true;
+    }
+#endif
+
+    long i = findReferencePosition(source->catalog, id);
+
+    if (i < 0)
+    {
+        return false;
+    }
+
+    *tiers = flatTiers(source->flat, i);
+    return true;
+
+}   /* findTiers() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that counts the references of the catalog or snapshot.
+ * @param  source  Catalog or snapshot of references.
+ * @return Number of references.
+ */
+static size_t referenceCount(const source_t * source)
+{
+    if (source->snapshot != NULL)
+    {
+        return source->snapshot->header->count;
+    }
+
+#ifdef EOQ_STATIC_CATALOG
+    if (source->catalog == NULL)
+    {
+        return STATIC_COUNT;
+    }
+#endif
+
+    return (source->flat->records).size();
+
+}   /* referenceCount() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that gets the ID and the description of a reference
+ *         of the catalog or snapshot, in catalog order.
+ * @param  source  Catalog or snapshot of references.
+ * @param  i  Position of the reference.
+ * @param  id  Where the ID is stored.
+ * @param  description  Where the description is stored.
+ * @return void
+ */
+static void referenceText(const source_t * source, size_t i,
+                          string * id, string * description)
+{
+    if (source->snapshot != NULL)
+    {
+        *id = snapshotId(source->snapshot, i);
+        *description = snapshotDescription(source->snapshot, i);
+        return;
+    }
+
+#ifdef EOQ_STATIC_CATALOG
+    if (source->catalog == NULL)
+    {
+        *id = STATIC_REFERENCES[i].id;
+        *description = STATIC_REFERENCES[i].description;
+        return;
+    }
+#endif
+
+    *id = flatId(source->flat, i);
+    *description = flatDescription(source->flat, i);
+
+}   /* referenceText() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that solves a reference of the catalog or snapshot
+ *         with its cost model, through the cache of solutions if there
+ *         is one. The exhaustive scan never uses the cache, so an audit
+ *         really scans every Q.
+ * @param  source  Catalog or snapshot of references.
+ * @param  id  ID of the reference.
+ * @param  D  Annual demand for the reference.
+ * @param  tiers  Tiers of the reference (from findTiers()).
+ * @return Costs of the optimal order.
+ */
+static solution_t solveReference(const source_t * source, const string & id,
+                                 int D, const tiers_t * tiers)
+{
+    if (source->solver == SOLVER_EXHAUSTIVE)
+    {
+        return scanOptimalQ(D, tiers, source->isa);
+    }
+
+    if (source->cache != NULL)
+    {
+        return cachedSolve(source->cache, id, D, source->stamp, tiers);
+    }
+
+    return solveModelQ(D, tiers);
+
+}   /* solveReference() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that writes the counters of the cache of solutions
+ *         (if there is one) to stderr.
+ * @param  source  Catalog or snapshot of references.
+ * @return void
+ */
+static void showCacheStats(const source_t * source)
+{
+    uint64_t hits, misses, entries;
+
+    if (source->cache == NULL)
+    {
+        return;
+    }
+
+    cacheStats(source->cache, &hits, &misses, &entries);
+    cerr << "cache: hits=" << hits << " misses=" << misses;
+    cerr << " entries=" << entries << "\n";
+
+}   /* showCacheStats() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that writes the metrics of the solves on stderr.
+ * @param  format  "json" or "prometheus", or NULL to write nothing.
+ * @return void
+ */
+static void showMetrics(const char * format)
+{
+    string text;
+
+    if (format == NULL)
+    {
+        return;
+    }
+
+    if (exportMetrics(format, &text) == false)
+    {
+        cerr << " -> Métricas: no disponibles en formato '" << format;
+        cerr << "' (compilar con -DEOQ_METRICS).\n";
+        return;
+    }
+
+    cerr << text;
+
+}   /* showMetrics() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that splits a batch row "ID<sep>D" (the separator can
+ *         be a comma, a semicolon or a tab) into its two fields.
+ * @param  line  Row to parse.
+ * @param  itemName  Where the reference ID is stored.
+ * @param  D  Where the Annual Demand is stored.
+ * @param  maxDemand  Largest Annual Demand accepted.
+ * @return false if the row does not have a valid ID and demand.
+ */
+static bool parseBatchRow(const string & line, string * itemName,
+                          int64_t * D, long long maxDemand)
+{
+    size_t sep = line.find_first_of(",;\t");
+
+    if (sep == string::npos)
+    {
+        return false;
+    }
+
+    // Trim the blanks around the reference ID
+    size_t first = line.find_first_not_of(" ");
+    size_t last = line.find_last_not_of(" ", sep - 1);
+
+    if ((first >= sep) || (last == string::npos))
+    {
+        return false;
+    }
+
+    itemName->assign(line, first, last - first + 1);
+
+    // The demand must be a whole number, optionally surrounded by blanks
+    const char * begin = line.c_str() + sep + 1;
+    char * end;
+
+    errno = 0;
+    long long value = strtoll(begin, &end, 10);
+
+    while ((*end == ' ') || (*end == '\r'))
+    {
+        end++;
+    }
+
+    if ((end == begin) || (*end != '\0') || (errno != 0) ||
+        (value <= 0) || (value > maxDemand))
+    {
+        return false;
+    }
+
+    *D = value;
+
+    return true;
+
+}   /* parseBatchRow() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that appends the CSV row of a solution to the output.
+ * @param  out  Output buffer.
+ * @param  itemName  Reference ID.
+ * @param  D  Annual Demand.
+ * @param  s  Solution of the reference.
+ * @return void
+ */
+static void appendSolution(string * out, const string & itemName, int D,
+                           const solution_t & s)
+{
+    char row[256];
+
+    snprintf(row, sizeof(row),
+             ",%d,%.3f,%.3f,%.3f,%d,%.2f,%.2f,%.2f,%.2f\n",
+             D, s.ca, s.ce, s.cp, s.Q, s.CA, s.CE, s.CP, s.CT);
+
+    *out += itemName;
+    *out += row;
+
+}   /* appendSolution() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that writes an amount in micro-units as a decimal
+ *         number, rounded half up with integer arithmetic only, so the
+ *         text is the same on every machine.
+ * @param  text  Where the number is written.
+ * @param  size  Size of text.
+ * @param  value  Amount in micro-units (not negative).
+ * @param  decimals  Decimals to write (0 to 6).
+ * @return void
+ */
+static void fixedText(char * text, size_t size, int64_t value, int decimals)
+{
+    int64_t unit = 1;
+
+    for (int d = decimals; d < 6; d++)
+    {
+        unit *= 10;
+    }
+
+    int64_t rounded = (value / unit) + ((value % unit) * 2 >= unit);
+    int64_t scale = FIXED_SCALE / unit;
+
+    snprintf(text, size, "%lld.%0*lld", (long long)(rounded / scale),
+             decimals, (long long)(rounded % scale));
+
+}   /* fixedText() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that appends the CSV row of a fixed-point solution to
+ *         the output, with the columns and decimals of appendSolution().
+ * @param  out  Output buffer.
+ * @param  itemName  Reference ID.
+ * @param  D  Annual Demand.
+ * @param  s  Solution of the reference.
+ * @return void
+ */
+static void appendFixedSolution(string * out, const string & itemName,
+                                int64_t D, const fixed_solution_t & s)
+{
+    const int64_t values[] = { s.ca, s.ce, s.cp, s.CA, s.CE, s.CP, s.CT };
+    char row[64];
+
+    snprintf(row, sizeof(row), ",%lld", (long long)D);
+    *out += itemName;
+    *out += row;
+
+    for (int v = 0; v < 7; v++)
+    {
+        row[0] = ',';
+        fixedText(row + 1, sizeof(row) - 1, values[v], (v < 3) ? 3 : 2);
+        *out += row;
+
+        // Q goes between the prices and the costs
+        if (v == 2)
+        {
+            snprintf(row, sizeof(row), ",%lld", (long long)s.Q);
+            *out += row;
+        }
+    }
+
+    *out += "\n";
+
+}   /* appendFixedSolution() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that gets the largest Annual Demand that the solver in
+ *         use accepts (the float solver scans Q up to 2·D in an int).
+ * @param  source  Catalog or snapshot of references.
+ * @return Largest Annual Demand.
+ */
+static long long maxDemand(const source_t * source)
+{
+    return (source->solver == SOLVER_FIXED) ? FIXED_MAX_DEMAND : (INT_MAX / 2);
+
+}   /* maxDemand() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that solves a reference with the solver in use and
+ *         appends the CSV row of its solution to the output.
+ * @param  out  Output buffer.
+ * @param  source  Catalog or snapshot of references.
+ * @param  itemName  Reference ID.
+ * @param  D  Annual Demand (up to maxDemand()).
+ * @param  tiers  Tiers of the reference (from findTiers()).
+ * @return false if the fixed-point solver could not solve it.
+ */
+static bool appendReference(string * out, const source_t * source,
+                            const string & itemName, int64_t D,
+                            const tiers_t * tiers)
+{
+    if (source->solver == SOLVER_FIXED)
+    {
+        fixed_solution_t s;
+
+        if (solveOptimalQFixed(D, tiers, &s) == false)
+        {
+            return false;
+        }
+
+        appendFixedSolution(out, itemName, D, s);
+        return true;
+    }
+
+    appendSolution(out, itemName, (int)D,
+                   solveReference(source, itemName, (int)D, tiers));
+
+    return true;
+
+}   /* appendReference() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that reads one (reference ID, Annual Demand) row of the
+ *         input and looks up its tiers. Empty lines and lines that start
+ *         with '#' are skipped, as is a header in the first line; any
+ *         other wrong row is reported on stderr.
+ * @param  line  Row to read.
+ * @param  lineNumber  Number of the row in the input (from 1).
+ * @param  source  Catalog or snapshot of references.
+ * @param  itemName  Where the reference ID is stored.
+ * @param  D  Where the Annual Demand is stored.
+ * @param  tiers  Where the tiers of the reference are stored.
+ * @param  errors  Incremented if the row is wrong.
+ * @return true if the row has a reference to solve.
+ */
+static bool readRow(const string & line, int lineNumber,
+                    const source_t * source, string * itemName, int64_t * D,
+                    tiers_t * tiers, int * errors)
+{
+    if (line.empty() || (line[0] == '#') || (line[0] == '\r'))
+    {
+        return false;
+    }
+
+    if (parseBatchRow(line, itemName, D, maxDemand(source)) == false)
+    {
+        // The first line may be a header such as "id,D"
+        if (lineNumber > 1)
+        {
+            cerr << " -> Línea " << lineNumber << ": se esperaba ";
+            cerr << "'ID,Demanda Anual' y se ha leído '" << line << "'.\n";
+            (*errors)++;
+        }
+        return false;
+    }
+
+    if (findTiers(source, *itemName, tiers) == false)
+    {
+        cerr << " -> Línea " << lineNumber << ": la referencia '";
+        cerr << *itemName << "' no está en el diccionario.\n";
+        (*errors)++;
+        return false;
+    }
+
+    return true;
+
+}   /* readRow() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that solves a whole list of (reference ID, Annual
+ *         Demand) rows with no interaction, read with readRow(). For
+ *         each row a CSV line with ca, ce, cp, Q*, CA, CE, CP and
+ *         CT is written to stdout through a large buffer, so there is
+ *         no flush per row.
+ * @param  input  Stream with the rows to solve (file or stdin).
+ * @param  source  Catalog or snapshot of references.
+ * @return Number of rows that could not be solved.
+ */
+static int runBatch(istream & input, const source_t * source)
+{
+    string line, itemName, out;
+    tiers_t tiers;
+    int64_t D;
+    int lineNumber = 0;
+    int errors = 0;
+
+    out.reserve(2 * BATCH_BUFFER_SIZE);
+    out += "id,D,ca,ce,cp,Q,CA,CE,CP,CT\n";
+
+    while (getline(input, line))
+    {
+        lineNumber++;
+
+        if (readRow(line, lineNumber, source, &itemName, &D, &tiers,
+                    &errors) == false)
+        {
+            continue;
+        }
+
+        if (appendReference(&out, source, itemName, D, &tiers) == false)
+        {
+            cerr << " -> Línea " << lineNumber << ": los costes de '";
+            cerr << itemName << "' no caben en 64 bits.\n";
+            errors++;
+            continue;
+        }
+
+        // Write full blocks only, instead of one system call per row
+        if (out.size() >= BATCH_BUFFER_SIZE)
+        {
+            fwrite(out.data(), 1, out.size(), stdout);
+            out.clear();
+        }
+    }
+
+    fwrite(out.data(), 1, out.size(), stdout);
+    fflush(stdout);
+
+    return errors;
+
+}   /* runBatch() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that reads every (reference ID, Annual Demand) row of
+ *         the input and looks up its tiers, with readRow().
+ * @param  input  Stream with the rows (file or stdin).
+ * @param  source  Catalog or snapshot of references.
+ * @param  names  Where the ID of each valid row is appended.
+ * @param  demands  Where the demand of each valid row is appended.
+ * @param  items  Where the tiers of each valid row are appended.
+ * @return Number of rows that could not be read.
+ */
+static int readRows(istream & input, const source_t * source,
+                    vector<string> * names, vector<int64_t> * demands,
+                    vector<tiers_t> * items)
+{
+    string line, itemName;
+    tiers_t tiers;
+    int64_t D;
+    int lineNumber = 0;
+    int errors = 0;
+
+    while (getline(input, line))
+    {
+        lineNumber++;
+
+        if (readRow(line, lineNumber, source, &itemName, &D, &tiers,
+                    &errors) == false)
+        {
+            continue;
+        }
+
+        names->push_back(itemName);
+        demands->push_back(D);
+        items->push_back(tiers);
+    }
+
+    return errors;
+
+}   /* readRows() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that solves every (reference ID, Annual Demand) row
+ *         of the input at once, spread over a work-stealing pool of
+ *         threads (see threadpool.h). Each row writes only its own
+ *         result, so the output is in input order for any number of
+ *         threads. The input format and the output are the ones of
+ *         runBatch().
+ *
+ *         With scaling, the solve is repeated with 1, 2, ... threads
+ *         and a CSV with the throughput of each run is written to
+ *         stderr. Each run starts with an empty cache of solutions, so
+ *         that every run really solves the rows.
+ * @param  input  Stream with the rows to solve (file or stdin).
+ * @param  source  Catalog or snapshot of references.
+ * @param  threads  Number of threads.
+ * @param  scaling  Whether to report the throughput from 1 to threads.
+ * @return Number of rows that could not be solved.
+ */
+static int runSolveAll(istream & input, const source_t * source, int threads,
+                       bool scaling)
+{
+    vector<string> names;
+    vector<int64_t> demands;
+    vector<tiers_t> items;
+
+    // Read and look up every row before solving
+    int errors = readRows(input, source, &names, &demands, &items);
+    bool fixed = (source->solver == SOLVER_FIXED);
+    vector<solution_t> solutions(fixed ? 0 : items.size());
+    vector<fixed_solution_t> fixedSolutions(fixed ? items.size() : 0);
+
+    auto solve = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            if (fixed)
+            {
+                // Q = 0 marks a row whose costs do not fit
+                if (solveOptimalQFixed(demands[i], &items[i],
+                                       &fixedSolutions[i]) == false)
+                {
+                    fixedSolutions[i].Q = 0;
+                }
+                continue;
+            }
+
+            solutions[i] = solveReference(source, names[i], (int)demands[i],
+                                          &items[i]);
+        }
+    };
+
+    if (scaling)
+    {
+        double base = 0.0;
+
+        cerr << "threads,seconds,solves_per_second,speedup\n";
+
+        for (int t = 1; t <= threads; t++)
+        {
+            if (source->cache != NULL)
+            {
+                initCache(source->cache, cacheCapacity(source->cache));
+            }
+
+            auto start = chrono::steady_clock::now();
+            parallelFor(items.size(), t, SOLVE_ALL_GRAIN, solve);
+            chrono::duration<double> elapsed;
+            elapsed = chrono::steady_clock::now() - start;
+
+            double rate = items.size() / max(elapsed.count(), 1e-9);
+            base = (t == 1) ? rate : base;
+
+            cerr << t << "," << elapsed.count() << "," << rate << ",";
+            cerr << (rate / base) << "\n";
+        }
+    }
+    else
+    {
+        parallelFor(items.size(), threads, SOLVE_ALL_GRAIN, solve);
+    }
+
+    // Write the results in input order
+    string out;
+
+    out.reserve(2 * BATCH_BUFFER_SIZE);
+    out += "id,D,ca,ce,cp,Q,CA,CE,CP,CT\n";
+
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        if (fixed == false)
+        {
+            appendSolution(&out, names[i], (int)demands[i], solutions[i]);
+        }
+        else if (fixedSolutions[i].Q > 0)
+        {
+            appendFixedSolution(&out, names[i], demands[i], fixedSolutions[i]);
+        }
+        else
+        {
+            cerr << " -> Los costes de '" << names[i] << "' con demanda ";
+            cerr << demands[i] << " no caben en 64 bits.\n";
+            errors++;
+        }
+
+        if (out.size() >= BATCH_BUFFER_SIZE)
+        {
+            fwrite(out.data(), 1, out.size(), stdout);
+            out.clear();
+        }
+    }
+
+    fwrite(out.data(), 1, out.size(), stdout);
+    fflush(stdout);
+
+    return errors;
+
+}   /* runSolveAll() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that orders every (reference ID, Annual Demand) row of
+ *         the input as one group that shares its shipments, with
+ *         solveJoint(). It writes a CSV row per reference with its
+ *         multiplier k, Q, tiers, CA and CP, then an empty line and a
+ *         CSV row with the base cycle T (years), the shipments per
+ *         year, the shared CE, the total CT, and the CT of ordering
+ *         each reference on its own.
+ * @param  input  Stream with the rows of the group (file or stdin).
+ * @param  source  Catalog or snapshot of references.
+ * @return Number of rows that could not be read.
+ */
+static int runJoint(istream & input, const source_t * source)
+{
+    vector<string> names;
+    vector<int64_t> demands;
+    vector<tiers_t> tiers;
+    int errors = readRows(input, source, &names, &demands, &tiers);
+    vector<joint_item_t> items(names.size());
+    double separate = 0.0;
+
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        items[i].tiers = tiers[i];
+        items[i].D = (int)demands[i];
+        separate += solveOptimalQ(items[i].D, &tiers[i]).CT;
+    }
+
+    joint_solution_t group;
+
+    if (solveJoint(&items, &group) == false)
+    {
+        cerr << " -> No hay ninguna referencia en el grupo.\n";
+        return errors + 1;
+    }
+
+    printf("id,D,k,Q,ca,ce,cp,CA,CP\n");
+
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        printf("%s,%d,%d,%d,%.3f,%.3f,%.3f,%.2f,%.2f\n", names[i].c_str(),
+               items[i].D, items[i].k, items[i].Q, items[i].ca, items[i].ce,
+               items[i].cp, items[i].CA, items[i].CP);
+    }
+
+    // A rounding difference (a single reference) is no saving
+    double saving = separate - group.CT;
+
+    if (fabs(saving) < 0.005)
+    {
+        saving = 0.0;
+    }
+
+    printf("\nT,shipments,CE,CT,CT_separate,saving\n");
+    printf("%.6f,%.2f,%.2f,%.2f,%.2f,%.2f\n", group.T, group.shipments,
+           group.CE, group.CT, separate, saving);
+    fflush(stdout);
+
+    return errors;
+
+}   /* runJoint() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that plans the orders of every row of the input under
+ *         caps on the average stock, with solveConstrained(). Each row
+ *         is "ID,D" or "ID,D,volume" (volume of one unit, 1 if it is
+ *         not given, so the volume cap counts units). It writes a CSV
+ *         row per reference with the volume, the constrained Q and its
+ *         tiers and CT, and the Q* of the reference on its own; then an
+ *         empty line and a CSV row with the multipliers, the stock held
+ *         against each cap, the total CT and the CT with no caps.
+ * @param  input  Stream with the rows (file or stdin).
+ * @param  source  Catalog or snapshot of references.
+ * @param  caps  Caps on the value and on the volume of the stock.
+ * @param  threads  Number of threads.
+ * @return Number of rows that could not be read, or 1 if the caps
+ *         cannot be met.
+ */
+static int runConstrained(istream & input, const source_t * source,
+                          const stock_caps_t * caps, int threads)
+{
+    vector<constrained_item_t> items;
+    vector<string> names;
+    string line, itemName;
+    tiers_t tiers;
+    int64_t D;
+    int lineNumber = 0;
+    int errors = 0;
+
+    while (getline(input, line))
+    {
+        lineNumber++;
+
+        if (line.empty() || (line[0] == '#') || (line[0] == '\r'))
+        {
+            continue;
+        }
+
+        // An optional third field is the volume of one unit
+        constrained_item_t item = { {}, 0, 1.0, 0, 0.0, 0.0, 0.0, 0.0 };
+        size_t sep = line.find_first_of(",;\t");
+        size_t third = (sep == string::npos) ? string::npos :
+                       line.find_first_of(",;\t", sep + 1);
+        bool volumeOk = true;
+
+        // The volume is read from its own copy of the field, which must
+        // hold a number and nothing else but blanks
+        if (third != string::npos)
+        {
+            string field = line.substr(third + 1);
+            const char * begin = field.c_str();
+            char * end;
+
+            item.volume = strtod(begin, &end);
+
+            while ((*end == ' ') || (*end == '\r'))
+            {
+                end++;
+            }
+
+            volumeOk = (end != begin) && (*end == '\0') &&
+                       isfinite(item.volume) && (item.volume >= 0);
+        }
+
+        if ((volumeOk == false) ||
+            (parseBatchRow(line.substr(0, third), &itemName, &D,
+                           INT_MAX / 2) == false))
+        {
+            // The first line may be a header such as "id,D,volume"
+            if (lineNumber > 1)
+            {
+                cerr << " -> Línea " << lineNumber << ": se esperaba ";
+                cerr << "'ID,Demanda Anual[,Volumen]' y se ha leído '";
+                cerr << line << "'.\n";
+                errors++;
+            }
+            continue;
+        }
+
+        if (findTiers(source, itemName, &tiers) == false)
+        {
+            cerr << " -> Línea " << lineNumber << ": la referencia '";
+            cerr << itemName << "' no está en el diccionario.\n";
+            errors++;
+            continue;
+        }
+
+        item.tiers = tiers;
+        item.D = (int)D;
+        items.push_back(item);
+        names.push_back(itemName);
+    }
+
+    // Cost of every reference on its own, with no caps
+    vector<int> free(items.size());
+    double freeCT = 0.0;
+
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        solution_t s = solveOptimalQ(items[i].D, &(items[i].tiers));
+
+        free[i] = s.Q;
+        freeCT += s.CT;
+    }
+
+    constrained_plan_t plan;
+
+    if (solveConstrained(&items, caps, threads, &plan) == false)
+    {
+        cerr << " -> Los límites no se cumplen ni pidiendo una unidad.\n";
+        return 1;
+    }
+
+    string out;
+    char row[256];
+
+    out += "id,D,volume,Q,ca,ce,cp,CT,Q_free\n";
+
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        snprintf(row, sizeof(row), ",%d,%g,%d,%.3f,%.3f,%.3f,%.2f,%d\n",
+                 items[i].D, items[i].volume, items[i].Q, items[i].ca,
+                 items[i].ce, items[i].cp, items[i].CT, free[i]);
+        out += names[i];
+        out += row;
+    }
+
+    snprintf(row, sizeof(row), "%g,%g,%.2f,%g,%.2f,%g,%.2f,%.2f\n",
+             plan.lambda, plan.mu, plan.value, caps->value, plan.volume,
+             caps->volume, plan.CT, freeCT);
+    out += "\nlambda,mu,value,value_cap,volume,volume_cap,CT,CT_free\n";
+    out += row;
+
+    fwrite(out.data(), 1, out.size(), stdout);
+    fflush(stdout);
+
+    return errors;
+
+}   /* runConstrained() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that sweeps a range of Annual Demands for one reference,
+ *         or for every reference of the catalog, with sweepOptimalQ().
+ *         By default only the change points are written, one CSV row
+ *         per piece with its demands, tiers, Q* and the CT at both ends
+ *         (CT is linear in between). With points, the whole curve is
+ *         written instead, one row per demand in the format of runBatch().
+ * @param  source  Catalog or snapshot of references.
+ * @param  D_min  First demand of the range.
+ * @param  D_max  Last demand of the range.
+ * @param  itemName  Reference to sweep, or empty for all of them.
+ * @param  points  Whether to write every demand instead of the pieces.
+ * @return Number of references that could not be swept.
+ */
+static int runSweep(const source_t * source, int D_min, int D_max,
+                    const string & itemName, bool points)
+{
+    vector<sweep_piece_t> pieces;
+    string id, description, out;
+    tiers_t tiers;
+    char row[256];
+    size_t count = itemName.empty() ? referenceCount(source) : 1;
+
+    out.reserve(2 * BATCH_BUFFER_SIZE);
+    out += points ? "id,D,ca,ce,cp,Q,CA,CE,CP,CT\n" :
+                    "id,D_from,D_to,ca,ce,cp,Q,CT_from,CT_to\n";
+
+    for (size_t r = 0; r < count; r++)
+    {
+        id = itemName;
+
+        if (itemName.empty())
+        {
+            referenceText(source, r, &id, &description);
+        }
+
+        if (findTiers(source, id, &tiers) == false)
+        {
+            cerr << " -> La referencia '" << id;
+            cerr << "' no está en el diccionario.\n";
+            return 1;
+        }
+
+        pieces.clear();
+        sweepOptimalQ(&tiers, D_min, D_max, &pieces);
+
+        for (const sweep_piece_t & piece : pieces)
+        {
+            if (points)
+            {
+                for (int D = piece.D_from; D <= piece.D_to; D++)
+                {
+                    appendSolution(&out, id, D,
+                                   pieceSolution(&tiers, &piece, D));
+
+                    if (out.size() >= BATCH_BUFFER_SIZE)
+                    {
+                        fwrite(out.data(), 1, out.size(), stdout);
+                        out.clear();
+                    }
+                }
+                continue;
+            }
+
+            solution_t first = pieceSolution(&tiers, &piece, piece.D_from);
+            solution_t last = pieceSolution(&tiers, &piece, piece.D_to);
+
+            snprintf(row, sizeof(row),
+                     ",%d,%d,%.3f,%.3f,%.3f,%d,%.2f,%.2f\n",
+                     piece.D_from, piece.D_to, first.ca, first.ce, first.cp,
+                     piece.Q, first.CT, last.CT);
+            out += id;
+            out += row;
+
+            if (out.size() >= BATCH_BUFFER_SIZE)
+            {
+                fwrite(out.data(), 1, out.size(), stdout);
+                out.clear();
+            }
+        }
+    }
+
+    fwrite(out.data(), 1, out.size(), stdout);
+    fflush(stdout);
+
+    return 0;
+
+}   /* runSweep() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that reads an event of the stream, "timestamp,ID,units"
+ *         (separated by ',', ';' or tabs), see parseStreamDay().
+ * @param  line  Line of the stream.
+ * @param  itemName  Where the ID of the reference is stored.
+ * @param  day  Where the day of the event is stored.
+ * @param  units  Where the units consumed are stored.
+ * @return false if the line is not a valid event.
+ */
+static bool parseStreamRow(const string & line, string * itemName,
+                           int64_t * day, int64_t * units)
+{
+    size_t first = line.find_first_of(",;\t");
+    size_t second = (first == string::npos) ? string::npos :
+                    line.find_first_of(",;\t", first + 1);
+
+    if ((second == string::npos) || (second == first + 1) ||
+        (parseStreamDay(line.c_str(), line.c_str() + first, day) == false))
+    {
+        return false;
+    }
+
+    itemName->assign(line, first + 1, second - first - 1);
+
+    const char * begin = line.c_str() + second + 1;
+    char * end;
+
+    errno = 0;
+    *units = strtoll(begin, &end, 10);
+
+    while ((*end == ' ') || (*end == '\r'))
+    {
+        end++;
+    }
+
+    return (end != begin) && (*end == '\0') && (errno == 0);
+
+}   /* parseStreamRow() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that follows the rolling annual demand of every
+ *         reference of a stream of daily consumptions, and writes a row
+ *         each time the Q* of one changes:
+ *
+ *           date,id,D,ca,ce,cp,Q,CT
+ *
+ *         Q = 0 means that the reference has no demand in the window.
+ * @param  input  Stream of "timestamp,ID,units" events, in time order
+ *                (events up to a year late are still counted).
+ * @param  source  Catalog or snapshot of references.
+ * @return Number of lines that could not be used.
+ */
+static int runStream(istream & input, const source_t * source)
+{
+    stream_t stream;
+    string line, itemName, out;
+    tiers_t tiers;
+    int64_t day, units;
+    int lineNumber = 0;
+    int errors = 0;
+    char row[160];
+    char date[32];
+
+    initStream(&stream);
+    out.reserve(2 * BATCH_BUFFER_SIZE);
+    out += "date,id,D,ca,ce,cp,Q,CT\n";
+
+    auto changed = [&](size_t i)
+    {
+        const stream_item_t & item = stream.items[i];
+        const solution_t & s = item.best;
+
+        civilDate(stream.today, date, sizeof(date));
+        snprintf(row, sizeof(row), ",%lld,%.3f,%.3f,%.3f,%d,%.2f\n",
+                 (long long)item.D, s.ca, s.ce, s.cp, s.Q, s.CT);
+        out += date;
+        out += ",";
+        out += stream.ids[i];
+        out += row;
+
+        if (out.size() >= BATCH_BUFFER_SIZE)
+        {
+            fwrite(out.data(), 1, out.size(), stdout);
+            out.clear();
+        }
+    };
+
+    while (getline(input, line))
+    {
+        lineNumber++;
+
+        if (line.empty() || (line[0] == '#') || (line[0] == '\r'))
+        {
+            continue;
+        }
+
+        if (parseStreamRow(line, &itemName, &day, &units) == false)
+        {
+            // The first line may be a header such as "date,id,units"
+            if (lineNumber > 1)
+            {
+                cerr << " -> Línea " << lineNumber << ": se esperaba ";
+                cerr << "'Fecha,ID,Unidades' y se ha leído '" << line;
+                cerr << "'.\n";
+                errors++;
+            }
+            continue;
+        }
+
+        long i = findStreamItem(&stream, itemName);
+
+        if (i < 0)
+        {
+            if (findTiers(source, itemName, &tiers) == false)
+            {
+                cerr << " -> Línea " << lineNumber << ": la referencia '";
+                cerr << itemName << "' no está en el diccionario.\n";
+                errors++;
+                continue;
+            }
+
+            i = (long)addStreamItem(&stream, itemName, &tiers);
+        }
+
+        addStreamEvent(&stream, i, day, units, changed);
+    }
+
+    fwrite(out.data(), 1, out.size(), stdout);
+    fflush(stdout);
+
+    cerr << "stream: events=" << stream.events << " late=" << stream.late;
+    cerr << " solves=" << stream.solves;
+    cerr << " references=" << stream.items.size() << "\n";
+
+    return errors;
+
+}   /* runStream() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that reads a sample of daily demands, one number of
+ *         units per line (empty lines and lines starting with '#' are
+ *         skipped).
+ * @param  path  File of the sample.
+ * @param  sample  Where the demands are stored.
+ * @param  error  Where the reason is stored if it cannot be read.
+ * @return false if the file cannot be read or a line is not a demand.
+ */
+static bool loadDemandSample(const char * path, vector<int> * sample,
+                             string * error)
+{
+    ifstream file(path);
+    string line;
+    int lineNumber = 0;
+
+    if (!file)
+    {
+        *error = "no se puede abrir el fichero";
+        return false;
+    }
+
+    while (getline(file, line))
+    {
+        lineNumber++;
+
+        if (line.empty() || (line[0] == '#') || (line[0] == '\r'))
+        {
+            continue;
+        }
+
+        char * end;
+        long units;
+
+        errno = 0;
+        units = strtol(line.c_str(), &end, 10);
+
+        while ((*end == ' ') || (*end == '\r'))
+        {
+            end++;
+        }
+
+        if ((end == line.c_str()) || (*end != '\0') || (errno != 0) ||
+            (units < 0) || (units > INT_MAX / 2))
+        {
+            *error = "línea " + to_string(lineNumber) + ": '" + line;
+            *error += "' no es una demanda diaria";
+            return false;
+        }
+
+        sample->push_back((int)units);
+    }
+
+    if (sample->empty())
+    {
+        *error = "no tiene ninguna demanda";
+        return false;
+    }
+
+    return true;
+
+}   /* loadDemandSample() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that simulates some years of the stock of a reference
+ *         under (Q, R) policies (see simulate.h) and writes a CSV row
+ *         per policy:
+ *
+ *           Q,R,orders,stockout,fill_rate,CA,CE,CP,CT,CT_error
+ *
+ *         with the orders and costs per year, the share of cycles with a
+ *         stockout, the share of units served on the day of their demand
+ *         and the standard error of the mean CT. With no policies, Q is
+ *         the Q* of the mean annual demand and R covers the demand of the
+ *         lead time plus z standard deviations of it, for z from 0 to 3.
+ * @param  source  Catalog or snapshot of references.
+ * @param  itemName  Reference to simulate.
+ * @param  model  Daily demand.
+ * @param  lead  Lead time, in days.
+ * @param  policies  Policies to simulate, or none for the default ones.
+ * @param  years  Years to simulate.
+ * @param  seed  Seed of the random numbers.
+ * @param  threads  Number of threads.
+ * @return 0 on success, 1 if the reference is not in the dictionary.
+ */
+static int runSimulate(const source_t * source, const string & itemName,
+                       demand_model_t * model, int lead,
+                       vector<policy_t> policies, long years, uint64_t seed,
+                       int threads)
+{
+    tiers_t tiers;
+
+    if (findTiers(source, itemName, &tiers) == false)
+    {
+        cerr << " -> La referencia '" << itemName;
+        cerr << "' no está en el diccionario.\n";
+        return 1;
+    }
+
+    // The sample is drawn as it is, but its moments size the policies
+    if (model->sample != NULL)
+    {
+        double sum = 0.0, squares = 0.0;
+
+        for (int units : *(model->sample))
+        {
+            sum += units;
+            squares += (double)units * units;
+        }
+
+        model->mean = sum / model->sample->size();
+        model->stddev = sqrt(max(0.0, squares / model->sample->size() -
+                                      model->mean * model->mean));
+    }
+
+    if (policies.empty())
+    {
+        double D = min(model->mean * SIMULATION_DAYS, INT_MAX / 2.0);
+        solution_t s = solveOptimalQ(max(1, (int)lround(D)), &tiers);
+        double leadMean = model->mean * lead;
+        double leadDeviation = model->stddev * sqrt((double)lead);
+
+        for (int z = 0; z <= 6; z++)
+        {
+            int R = (int)lround(leadMean + 0.5 * z * leadDeviation);
+
+            if (policies.empty() || (policies.back().R != R))
+            {
+                policies.push_back({ max(1, s.Q), R });
+            }
+        }
+    }
+
+    vector<policy_stats_t> stats;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    simulatePolicies(&tiers, model, lead, policies, years, seed, threads,
+                     &stats);
+
+    double seconds = chrono::duration<double>(
+                         chrono::steady_clock::now() - start).count();
+    string out;
+    char row[256];
+
+    out += "Q,R,orders,stockout,fill_rate,CA,CE,CP,CT,CT_error\n";
+
+    for (size_t p = 0; p < policies.size(); p++)
+    {
+        const policy_stats_t & sum = stats[p];
+        double n = sum.years;
+        double CT = sum.CT / n;
+        double variance = max(0.0, sum.CT2 / n - CT * CT);
+
+        snprintf(row, sizeof(row),
+                 "%d,%d,%.3f,%.5f,%.5f,%.2f,%.2f,%.2f,%.2f,%.2f\n",
+                 policies[p].Q, policies[p].R, sum.orders / n,
+                 (sum.cycles > 0) ? (sum.stockouts / sum.cycles) : 0.0,
+                 (sum.demand > 0) ? (1.0 - sum.backordered / sum.demand) : 1.0,
+                 sum.CA / n, sum.CE / n, sum.CP / n, CT,
+                 sqrt(variance / n));
+        out += row;
+    }
+
+    fwrite(out.data(), 1, out.size(), stdout);
+    fflush(stdout);
+
+    cerr << "simulate: years=" << (long)stats[0].years;
+    cerr << " policies=" << policies.size() << " threads=" << threads;
+    cerr << " seconds=" << seconds << "\n";
+
+    return 0;
+
+}   /* runSimulate() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that splits a row of period demands "ID,d1,d2,..."
+ *         (separated by ',', ';' or tabs).
+ * @param  line  Row to parse.
+ * @param  itemName  Where the reference ID is stored.
+ * @param  demand  Where the units of each period are stored.
+ * @return false if the row does not have an ID and whole demands (0 or
+ *         more, adding up to at most INT_MAX / 2).
+ */
+static bool parsePeriodRow(const string & line, string * itemName,
+                           vector<int> * demand)
+{
+    size_t sep = line.find_first_of(",;\t");
+    size_t first = line.find_first_not_of(" ");
+
+    if ((sep == string::npos) || (first >= sep))
+    {
+        return false;
+    }
+
+    itemName->assign(line, first, line.find_last_not_of(" ", sep - 1) -
+                                   first + 1);
+    demand->clear();
+
+    const char * begin = line.c_str() + sep + 1;
+    long long total = 0;
+
+    for (;;)
+    {
+        char * end;
+
+        errno = 0;
+        long long units = strtoll(begin, &end, 10);
+
+        while ((*end == ' ') || (*end == '\r'))
+        {
+            end++;
+        }
+
+        total += units;
+
+        if ((end == begin) || (errno != 0) || (units < 0) ||
+            (total > INT_MAX / 2) ||
+            ((*end != '\0') && (strchr(",;\t", *end) == NULL)))
+        {
+            return false;
+        }
+
+        demand->push_back((int)units);
+
+        if (*end == '\0')
+        {
+            return true;
+        }
+
+        begin = end + 1;
+    }
+
+}   /* parsePeriodRow() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that plans the orders of every row of period demands of
+ *         the input with solveLotSizing(), spread over the threads. It
+ *         writes a CSV row per order (periods counted from 1):
+ *
+ *           id,period,periods,Q,ca,ce,cp,cost
+ *
+ *         then an empty line and a CSV row per reference with its total
+ *         demand, its orders and the cost of the horizon.
+ * @param  input  Stream of "ID,d1,d2,..." rows (file or stdin).
+ * @param  source  Catalog or snapshot of references.
+ * @param  periodsPerYear  Periods of a year (12 for months...).
+ * @param  threads  Number of threads.
+ * @return Number of rows that could not be planned.
+ */
+static int runLotSizing(istream & input, const source_t * source,
+                        int periodsPerYear, int threads)
+{
+    vector<string> names;
+    vector<vector<int>> demands;
+    vector<tiers_t> items;
+    string line, itemName;
+    vector<int> demand;
+    tiers_t tiers;
+    int lineNumber = 0;
+    int errors = 0;
+
+    while (getline(input, line))
+    {
+        lineNumber++;
+
+        if (line.empty() || (line[0] == '#') || (line[0] == '\r'))
+        {
+            continue;
+        }
+
+        if (parsePeriodRow(line, &itemName, &demand) == false)
+        {
+            // The first line may be a header such as "id,m1,m2,..."
+            if (lineNumber > 1)
+            {
+                cerr << " -> Línea " << lineNumber << ": se esperaba ";
+                cerr << "'ID,Demanda1,Demanda2,...' y se ha leído '";
+                cerr << line << "'.\n";
+                errors++;
+            }
+            continue;
+        }
+
+        if (findTiers(source, itemName, &tiers) == false)
+        {
+            cerr << " -> Línea " << lineNumber << ": la referencia '";
+            cerr << itemName << "' no está en el diccionario.\n";
+            errors++;
+            continue;
+        }
+
+        names.push_back(itemName);
+        demands.push_back(demand);
+        items.push_back(tiers);
+    }
+
+    vector<lot_plan_t> plans(items.size());
+
+    auto plan = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            solveLotSizing(&items[i], demands[i], periodsPerYear, &plans[i]);
+        }
+    };
+
+    parallelFor(items.size(), threads, LOT_SIZING_GRAIN, plan);
+
+    // Write the plans in input order
+    string out, totals;
+    char row[256];
+    uint64_t evaluated = 0;
+
+    out.reserve(2 * BATCH_BUFFER_SIZE);
+    out += "id,period,periods,Q,ca,ce,cp,cost\n";
+    totals += "\nid,D,orders,CT\n";
+
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        long long D = 0;
+
+        for (const lot_order_t & order : plans[i].orders)
+        {
+            snprintf(row, sizeof(row), ",%d,%d,%d,%.3f,%.3f,%.3f,%.2f\n",
+                     order.period + 1, order.periods, order.Q, order.ca,
+                     order.ce, order.cp, order.cost);
+            out += names[i];
+            out += row;
+            D += order.Q;
+
+            if (out.size() >= BATCH_BUFFER_SIZE)
+            {
+                fwrite(out.data(), 1, out.size(), stdout);
+                out.clear();
+            }
+        }
+
+        snprintf(row, sizeof(row), ",%lld,%zu,%.2f\n", D,
+                 plans[i].orders.size(), plans[i].CT);
+        totals += names[i];
+        totals += row;
+        evaluated += plans[i].evaluated;
+    }
+
+    out += totals;
+    fwrite(out.data(), 1, out.size(), stdout);
+    fflush(stdout);
+
+    cerr << "lot-sizing: references=" << items.size();
+    cerr << " orders_evaluated=" << evaluated << "\n";
+
+    return errors;
+
+}   /* runLotSizing() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that expands the demands of the finished products of the
+ *         input through a bill of materials (see bom.h) and solves the
+ *         Q* of every component of the catalog with the demand that
+ *         results, rounded up to whole units. The rows are the ones of
+ *         runBatch() (a row may also name a component, for spare parts)
+ *         and so is the output, in the order of the BOM file. Products
+ *         that are not in the catalog are made, not bought: they are not
+ *         solved.
+ * @param  input  Stream of "ID,D" rows of the products (file or stdin).
+ * @param  source  Catalog or snapshot of references.
+ * @param  bomPath  BOM file.
+ * @return Number of rows or components that could not be solved.
+ */
+static int runBom(istream & input, const source_t * source,
+                  const char * bomPath)
+{
+    bom_t bom;
+    string line, itemName, error;
+    int64_t D;
+    int lineNumber = 0;
+    int errors = 0;
+
+    if (loadBom(bomPath, &bom, &error) == false)
+    {
+        cerr << " -> BOM '" << bomPath << "': " << error << ".\n";
+        return 1;
+    }
+
+    vector<double> demand(bom.names.size(), 0.0);
+
+    while (getline(input, line))
+    {
+        lineNumber++;
+
+        if (line.empty() || (line[0] == '#') || (line[0] == '\r'))
+        {
+            continue;
+        }
+
+        if (parseBatchRow(line, &itemName, &D, maxDemand(source)) == false)
+        {
+            // The first line may be a header such as "id,D"
+            if (lineNumber > 1)
+            {
+                cerr << " -> Línea " << lineNumber << ": se esperaba ";
+                cerr << "'ID,Demanda Anual' y se ha leído '" << line << "'.\n";
+                errors++;
+            }
+            continue;
+        }
+
+        uint32_t node = addBomLeaf(&bom, itemName);
+
+        demand.resize(bom.names.size(), 0.0);
+        demand[node] += D;
+    }
+
+    expandBom(&bom, &demand);
+
+    string out;
+    tiers_t tiers;
+    size_t components = 0;
+
+    out.reserve(2 * BATCH_BUFFER_SIZE);
+    out += "id,D,ca,ce,cp,Q,CA,CE,CP,CT\n";
+
+    for (size_t node = 0; node < bom.names.size(); node++)
+    {
+        const string & id = bom.names[node];
+        bool product = (bom.first[node + 1] > bom.first[node]);
+
+        if (findTiers(source, id, &tiers) == false)
+        {
+            if (product == false)
+            {
+                cerr << " -> El componente '" << id;
+                cerr << "' no está en el diccionario.\n";
+                errors++;
+            }
+            continue;
+        }
+
+        double units = bomUnits(demand[node]);
+
+        if (units < 1.0)
+        {
+            continue;
+        }
+
+        if ((units > maxDemand(source)) ||
+            (appendReference(&out, source, id, (int64_t)units,
+                             &tiers) == false))
+        {
+            cerr << " -> La demanda de '" << id << "' (" << units;
+            cerr << ") no se puede resolver.\n";
+            errors++;
+            continue;
+        }
+
+        components++;
+
+        if (out.size() >= BATCH_BUFFER_SIZE)
+        {
+            fwrite(out.data(), 1, out.size(), stdout);
+            out.clear();
+        }
+    }
+
+    fwrite(out.data(), 1, out.size(), stdout);
+    fflush(stdout);
+
+    cerr << "bom: nodes=" << bom.names.size() << " lines=";
+    cerr << bom.edges.size() << " solved=" << components << "\n";
+
+    return errors;
+
+}   /* runBom() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that writes the cost curve of a reference for an Annual
+ *         Demand, with the points of sampleCurve(), as CSV or binary
+ *         (see curve.h).
+ * @param  source  Catalog or snapshot of references.
+ * @param  itemName  Reference of the curve.
+ * @param  D  Annual Demand.
+ * @param  samples  Points that each segment may add.
+ * @param  binary  Whether to write the binary format instead of CSV.
+ * @param  path  File to write, or NULL for stdout.
+ * @return 0 on success, 1 if the reference is not in the dictionary or
+ *         the curve cannot be written.
+ */
+static int runCurve(const source_t * source, const string & itemName, int D,
+                    int samples, bool binary, const char * path)
+{
+    vector<curve_point_t> points;
+    tiers_t tiers;
+    string error;
+
+    if (findTiers(source, itemName, &tiers) == false)
+    {
+        cerr << " -> La referencia '" << itemName;
+        cerr << "' no está en el diccionario.\n";
+        return 1;
+    }
+
+    sampleCurve(D, &tiers, samples, CURVE_TOLERANCE, &points);
+
+    if (exportCurve(points, D, binary, path, &error) == false)
+    {
+        cerr << " -> Curva: " << error << ".\n";
+        return 1;
+    }
+
+    return 0;
+
+}   /* runCurve() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that picks the best supplier and its Q* for every
+ *         (reference ID, Annual Demand) row of the input with
+ *         solveSuppliers(), spread over the threads. It writes a CSV
+ *         row per reference in input order, as runBatch() with the
+ *         supplier ("-" for the tiers of the catalog):
+ *
+ *           id,D,supplier,ca,ce,cp,Q,CA,CE,CP,CT
+ *
+ *         and on stderr how many offers had to be solved.
+ * @param  input  Stream with the rows to solve (file or stdin).
+ * @param  source  Catalog with the offers (see --offers).
+ * @param  threads  Number of threads.
+ * @return Number of rows that could not be solved.
  */
+static int runSuppliers(istream & input, const source_t * source,
+                        int threads)
+{
+    vector<string> names;
+    vector<int64_t> demands;
+    vector<tiers_t> tiers;
+    int errors = readRows(input, source, &names, &demands, &tiers);
+    vector<supplier_choice_t> choices(names.size());
 
-//-----[ INCLUDES ]-----------------------------------------------------------//
+    auto solve = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            solveSuppliers((int)demands[i],
+                           findReference(source->catalog, names[i]),
+                           &choices[i]);
+        }
+    };
 
-#include "references.h"
+    parallelFor(names.size(), threads, SUPPLIERS_GRAIN, solve);
 
-#include <iostream>
-#include <iomanip> // Para std::setw
-#include <math.h>
-#include <unordered_map>
-#include <vector>
-#include <limits> // Para std::numeric_limits
+    string out;
+    char row[256];
+    uint64_t offers = 0, solved = 0;
 
-using namespace std;
+    out.reserve(2 * BATCH_BUFFER_SIZE);
+    out += "id,D,supplier,ca,ce,cp,Q,CA,CE,CP,CT\n";
+
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        const reference_t * item = findReference(source->catalog, names[i]);
+        const supplier_choice_t & choice = choices[i];
+        const solution_t & s = choice.solution;
+
+        snprintf(row, sizeof(row),
+                 ",%.3f,%.3f,%.3f,%d,%.2f,%.2f,%.2f,%.2f\n",
+                 s.ca, s.ce, s.cp, s.Q, s.CA, s.CE, s.CP, s.CT);
+        out += names[i] + "," + to_string(demands[i]) + ",";
+        out += (choice.offer < 0) ? "-" : item->offers[choice.offer].supplier;
+        out += row;
+        offers += item->offers.size() + 1;
+        solved += choice.solved;
+
+        if (out.size() >= BATCH_BUFFER_SIZE)
+        {
+            fwrite(out.data(), 1, out.size(), stdout);
+            out.clear();
+        }
+    }
+
+    fwrite(out.data(), 1, out.size(), stdout);
+    fflush(stdout);
 
-//-----[ COLORS ]-------------------------------------------------------------//
+    cerr << "suppliers: offers=" << offers << " solved=" << solved << "\n";
 
-#define RESET_COLOR	"\e[0m"
-#define BOLD        "\e[1;37m"
-#define CYAN_T   	"\e[1;36m"
-#define YELLOW   	"\e[1;33m"
-#define WHITE       "\e[1;37m"
-#define RED         "\e[0;31m"
+    return errors;
 
-//-----[ IMPLEMENTATION OF THE FUNCTION ]-------------------------------------//
+}   /* runSuppliers() */
 
 /******************************************************************************/
 /*!
- * @brief  Method that calculates the Q* of a reference given
- *         a specific Annual Demand (D). It shows a table with
- *         the values ​​of ce, ca, cp, Q*, CA, CE, CP and CT.
- * @param  D  This number indicates the annual demand for the reference.
- * @param  item  Pointer to reference.
+ * @brief  Method that answers one request of the daemon: a line with
+ *         "ID,D" (as in runBatch()) gets "OK," and the CSV row of the
+ *         solution, "STATS" gets "OK,hits,misses,entries" of the cache,
+ *         and anything else gets "ERR," and the reason.
+ * @param  source  Catalog or snapshot of references.
+ * @param  line  Request, without the '\n'.
+ * @param  length  Length of the request.
+ * @param  out  Output buffer of the connection.
  * @return void
  */
-void showOptimalQ(int D, reference_t * item)
+static void answerRequest(const source_t * source, const char * line,
+                          size_t length, string * out)
 {
-    float optimal_Q = 0.0;
-    float optimal_ca, optimal_ce, optimal_cp, min_CA, optimal_CE, optimal_CP;
-    float min_CT = MAXFLOAT;
+    string request(line, length);
+    string itemName;
+    tiers_t tiers;
+    int64_t D;
 
-    for (int i = 1; i <= (D * 2); i++)
+    if (request == "STATS")
     {
-        // Find ca
-        float ca;
-        for (int j = 0; j < (item->ca_list).size(); j++)
+        uint64_t hits = 0, misses = 0, entries = 0;
+
+        if (source->cache != NULL)
         {
-            if ((i >= (item->ca_list[j]).min_unit) && 
-                (((i < (item->ca_list[j + 1]).min_unit) ||
-                  (j + 1 == ((item->ca_list).size())))))
-            {
-                ca = (item->ca_list[j]).value; 
-            }         
+            cacheStats(source->cache, &hits, &misses, &entries);
         }
 
-        // Find ce
-        float ce;
-        for (int j = 0; j < (item->ce_list).size(); j++)
+        *out += "OK," + to_string(hits) + "," + to_string(misses) + ",";
+        *out += to_string(entries) + "\n";
+        return;
+    }
+
+    if (request == "METRICS")
+    {
+        string metrics;
+
+        if (exportMetrics("json", &metrics) == false)
         {
-            if ((i >= (item->ce_list[j]).min_unit) && 
-                (((i < (item->ce_list[j + 1]).min_unit) ||
-                  (j + 1 == ((item->ce_list).size())))))
-            {
-                ce = ((item->ce_list[j]).value); 
-            }         
+            *out += "ERR,compilado sin métricas\n";
+            return;
         }
 
-        // Find cp
-        float cp = item->cp_percentage * ca;
+        *out += "OK," + metrics;
+        return;
+    }
+
+    if (parseBatchRow(request, &itemName, &D, maxDemand(source)) == false)
+    {
+        *out += "ERR,se esperaba 'ID,Demanda Anual'\n";
+        return;
+    }
+
+    if (findTiers(source, itemName, &tiers) == false)
+    {
+        *out += "ERR,la referencia '" + itemName;
+        *out += "' no está en el diccionario\n";
+        return;
+    }
 
-        // Calculate CA
-        float CA = ca * (D * 1.0);
+    string row;
 
-        // Calculate CE
-        float CE = ce * ((D * 1.0) / (i * 1.0));
+    if (appendReference(&row, source, itemName, D, &tiers) == false)
+    {
+        *out += "ERR,los costes no caben en 64 bits\n";
+        return;
+    }
 
-        // Calculate CP
-        float CP = cp * ((i * 1.0) / 2.0);
+    *out += "OK,";
+    *out += row;
 
-        // Calculate CT
-        float CT = CA + CE + CP;
+}   /* answerRequest() */
 
-        // If the calculated CT is less than min_CT, update the values
-        if (CT < min_CT)
-        {
-            optimal_Q = i;
-            
-            optimal_ca = ca;
-            optimal_ce = ce;
-            optimal_cp = cp;
-            min_CA = CA;
-            optimal_CE = CE;
-            optimal_CP = CP;
-            min_CT = CT;
-        }
+/******************************************************************************/
+/*!
+ * @brief  Method that counts the characters that a UTF-8 string takes
+ *         on the terminal (bytes that do not continue a character).
+ * @param  text  String to measure.
+ * @return Number of columns of the string.
+ */
+static size_t textWidth(const string & text)
+{
+    size_t width = 0;
+
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        width += (((unsigned char)text[i] & 0xC0) != 0x80);
+    }
+
+    return width;
+
+}   /* textWidth() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that shows the table with the ID and the description
+ *         of every reference of the catalog. The columns grow with the
+ *         longest ID and description.
+ * @param  source  Catalog or snapshot of references.
+ * @return void
+ */
+static void showReferencesTable(const source_t * source)
+{
+    size_t idWidth = textWidth("tapon-spray");
+    size_t descriptionWidth = textWidth("Descripción");
+    string id, description;
+
+    for (size_t i = 0; i < referenceCount(source); i++)
+    {
+        referenceText(source, i, &id, &description);
+
+        idWidth = max(idWidth, textWidth(id));
+        descriptionWidth = max(descriptionWidth, textWidth(description));
     }
 
-    cout << endl;
+    string idLine(idWidth + 2, '-');
+    string descriptionLine(descriptionWidth + 2, '-');
+    string title = "TABLA DE REFERENCIAS";
 
-    // Set the format to display three decimal precision
-    cout << fixed << setprecision(3);
+    cout << "+" << idLine << "-" << descriptionLine << "+" << endl;
+    cout << "| " << BOLD << title << RESET_COLOR;
+    cout << string(idWidth + descriptionWidth + 4 - title.size(), ' ');
+    cout << "|" << endl;
+    cout << "+" << idLine << "+" << descriptionLine << "+" << endl;
+    cout << "| " << BOLD << "ID" << RESET_COLOR << string(idWidth - 2, ' ');
+    cout << " | " << BOLD << "Descripción" << RESET_COLOR;
+    cout << string(descriptionWidth - textWidth("Descripción"), ' ');
+    cout << " |" << endl;
+    cout << "+" << idLine << "+" << descriptionLine << "+" << endl;
+
+    for (size_t i = 0; i < referenceCount(source); i++)
+    {
+        referenceText(source, i, &id, &description);
 
-    cout << "+-------------------+" << endl;
-    cout << "| ca: " << setw(9) << optimal_ca << " €   |" << endl;
-    cout << "| ce: " << setw(9) << optimal_ce << " €   |" << endl;
-    cout << "| cp: " << setw(9) << optimal_cp << " €   |" << endl;
-    cout << "|-------------------|" << endl;
+        cout << "| " << id << string(idWidth - textWidth(id), ' ');
+        cout << " | " << description;
+        cout << string(descriptionWidth - textWidth(description), ' ');
+        cout << " |" << endl;
+    }
 
-    // Set the format to display zero decimal precision
-    cout << fixed << setprecision(0);
+    cout << "+" << idLine << "+" << descriptionLine << "+" << endl;
 
-    cout << "| " << BOLD << "Q*: " << setw(9) << optimal_Q;
-    cout << " ud. " << RESET_COLOR << "|" << endl;
-    cout << "|-------------------|" << endl;
+}   /* showReferencesTable() */
 
-    // Set the format to display two decimal precision
-    cout << fixed << setprecision(2);
+/******************************************************************************/
+/*!
+ * @brief  Method that fills the catalog with the references compiled
+ *         from references.h (or catalog_static.h), used when no catalog
+ *         file is given.
+ * @param  catalog  Catalog that receives the references.
+ * @return void
+ */
+static void loadBuiltinCatalog(catalog_t * catalog)
+{
+    string error;
 
-    cout << "| CA: " << setw(9) << min_CA << " €   |" << endl;
-    cout << "| CE: " << setw(9) << optimal_CE << " €   |" << endl;
-    cout << "| CP: " << setw(9) << optimal_CP << " €   |" << endl;
-    cout << "|-------------------|" << endl;
-    cout << "| CT: " << setw(9) << min_CT << " €   |" << endl;
-    cout << "+-------------------+" << endl;
+#ifdef EOQ_STATIC_CATALOG
+    for (size_t i = 0; i < STATIC_COUNT; i++)
+    {
+        const static_reference_t & item = STATIC_REFERENCES[i];
+        reference_t reference = {};
 
-    cout << endl;
+        reference.id = item.id;
+        reference.description = item.description;
+        reference.ca_list.assign(item.ca_list, item.ca_list + item.ca_count);
+        reference.ce_list.assign(item.ce_list, item.ce_list + item.ce_count);
+        reference.cp_percentage = item.cp_percentage;
+        addReference(catalog, reference, &error);
+    }
+#else
+    for (size_t i = 0; i < R_ALL_COUNT; i++)
+    {
+        addReference(catalog, *R_ALL[i], &error);
+    }
+#endif
 
-}   /* showOptimalQ() */
+}   /* loadBuiltinCatalog() */
 
 /******************************************************************************/
 /*!
  * @brief  Main program that displays a simple
  *         graphical interface through the terminal.
- * @param  void
- * @return void
+ *         Options:
+ *           --catalog FILE   Load the references from FILE (see catalog.h)
+ *                            instead of the ones compiled from references.h.
+ *           --compile FILE   Write the binary snapshot of the catalog to
+ *                            FILE and exit (see snapshot.h).
+ *           --snapshot FILE  Map the references from a binary snapshot.
+ *           --export-static FILE  Write the catalog as constexpr data to
+ *                            FILE and exit (see static_catalog.h).
+ *           --batch [FILE]   Solve every row of FILE (or stdin) with no
+ *                            interaction, see runBatch().
+ *           --solve-all [FILE]  Like --batch, but solving all the rows
+ *                            in parallel, see runSolveAll().
+ *           --threads N      Threads of --solve-all (default: all cores).
+ *           --scaling        Report the --solve-all throughput from 1
+ *                            to N threads on stderr.
+ *           --serve SOCKET   Answer "ID,D" lines on a Unix domain socket
+ *                            until SIGINT/SIGTERM, see answerRequest().
+ *           --cache N        Keep the last N solutions (see cache.h).
+ *           --sweep DMIN DMAX [ID]  Write the pieces of Q*(D) for every
+ *                            D in [DMIN, DMAX], of ID or of every
+ *                            reference, see runSweep().
+ *           --points         Write every D of --sweep, not only the pieces.
+ *           --fixed          Solve --batch, --solve-all and --serve with
+ *                            64-bit demands in fixed point (see fixed.h).
+ *           --exhaustive     Solve them by evaluating every Q instead
+ *                            (see exhaustive.h), to audit the solver.
+ *           --joint [FILE]   Order every row of FILE (or stdin) as one
+ *                            group that shares its shipments, see
+ *                            runJoint().
+ *           --constrained [FILE]  Plan every row of FILE (or stdin) under
+ *                            the caps of --budget and --space, with
+ *                            --threads, see runConstrained().
+ *           --budget VALUE   Cap on the value of the average stock.
+ *           --space VOLUME   Cap on the volume of the average stock.
+ *           --stream [FILE]  Follow the rolling annual demand of a
+ *                            stream of "timestamp,ID,units" events of
+ *                            FILE (or stdin), see runStream().
+ *           --simulate ID    Simulate the stock of ID under (Q, R)
+ *                            policies and write their costs and
+ *                            stockouts, see runSimulate().
+ *           --demand MEAN:STDDEV  Normal daily demand of --simulate.
+ *           --sample FILE    Daily demands of --simulate to draw from.
+ *           --lead DAYS      Lead time of --simulate (default: 0).
+ *           --years N        Years of --simulate (default: 100000).
+ *           --seed S         Seed of --simulate (default: 1).
+ *           --policy Q:R     Policy of --simulate (repeatable; default:
+ *                            Q* with safety stocks of 0 to 3 sigma).
+ *           --lot-sizing [FILE]  Plan the orders of every row of period
+ *                            demands "ID,d1,d2,..." of FILE (or stdin),
+ *                            with --threads, see runLotSizing().
+ *           --periods N      Periods per year of --lot-sizing (default:
+ *                            12, one per month).
+ *           --bom BOM [FILE]  Expand the "ID,D" rows of the products of
+ *                            FILE (or stdin) through the bill of
+ *                            materials BOM and solve every component,
+ *                            see runBom().
+ *           --curve ID D [FILE]  Write CA, CE, CP and CT versus Q of ID
+ *                            to FILE (or stdout), see runCurve().
+ *           --samples N      Points of --curve inside each segment at
+ *                            most (default: 64).
+ *           --binary         Write --curve in binary instead of CSV.
+ *           --offers FILE    Load the offers of other suppliers of the
+ *                            references from FILE (see suppliers.h).
+ *           --suppliers [FILE]  Pick the best supplier and Q* of every
+ *                            "ID,D" row of FILE (or stdin), with
+ *                            --threads, see runSuppliers().
+ *           --metrics FORMAT  Write the counters of the solves on stderr
+ *                            on exit, as "json" or "prometheus" (needs
+ *                            -DEOQ_METRICS, see metrics.h).
+ * @param  argc  Number of command line arguments.
+ * @param  argv  Command line arguments.
+ * @return 0 on success, 1 on a bad catalog or if any batch row failed.
  */
-int main(void)
-{
-    // Create dictionary of references
-    unordered_map<string, reference_t> referencesDict;
-
-    // Add all references from (references.h) to the dictionary
-    referencesDict.insert({     "NVLS745", R_NVLS745    });
-    referencesDict.insert({      "110212", R_110212     });
-    referencesDict.insert({   "260024045", R_260024045  });
-    referencesDict.insert({   "260024046", R_260024046  });
-    referencesDict.insert({      "303117", R_303117     });
-    referencesDict.insert({      "110102", R_110102     });
-    referencesDict.insert({      "110207", R_110207     });
-    referencesDict.insert({     "CAJ1205", R_CAJ1205    });
-    referencesDict.insert({    "STO69015", R_STO69015   });
-    referencesDict.insert({  "tapon-PP28", R_taponPP28  });
-    referencesDict.insert({  "CUDOS/1000", R_CUDOS1000  });
-    referencesDict.insert({  "30ml-DIN18", R_30mlDIN18  });
-    referencesDict.insert({ "tapon-spray", R_taponspray });
-    referencesDict.insert({     "caja_01", R_caja_01    });
-    referencesDict.insert({     "caja_02", R_caja_02    });
-    referencesDict.insert({     "caja_03", R_caja_03    });
-    referencesDict.insert({     "caja_04", R_caja_04    });  
+int main(int argc, char * argv[])
+{
+    const char * catalogPath = NULL;
+    const char * compilePath = NULL;
+    const char * snapshotPath = NULL;
+    const char * exportPath = NULL;
+    const char * metricsFormat = NULL;
+    const char * inputPath = NULL;
+    const char * samplePath = NULL;
+    const char * bomPath = NULL;
+    const char * offersPath = NULL;
+    run_mode_t mode = MODE_INTERACTIVE;
+    bool scaling = false;
+    bool points = false;
+    solver_t solver = SOLVER_SEGMENTS;
+    stock_caps_t caps = { 0.0, 0.0 };
+    int sweepRange[2] = { 0, 0 };
+    int threads = defaultThreads();
+    long cacheSize = 0;
+    demand_model_t demand = { -1.0, 0.0, NULL };
+    vector<policy_t> policies;
+    int lead = 0;
+    int periodsPerYear = 12;
+    int curveDemand = 0;
+    int samples = CURVE_DEFAULT_SAMPLES;
+    bool binary = false;
+    const char * curveItem = NULL;
+    long years = 100000;
+    uint64_t seed = 1;
+
+    // Read the command line options
+    for (int a = 1; a < argc; a++)
+    {
+        if ((strcmp(argv[a], "--catalog") == 0) && (a + 1 < argc))
+        {
+            catalogPath = argv[++a];
+        }
+        else if ((strcmp(argv[a], "--compile") == 0) && (a + 1 < argc))
+        {
+            compilePath = argv[++a];
+        }
+        else if ((strcmp(argv[a], "--snapshot") == 0) && (a + 1 < argc))
+        {
+            snapshotPath = argv[++a];
+        }
+        else if ((strcmp(argv[a], "--export-static") == 0) && (a + 1 < argc))
+        {
+            exportPath = argv[++a];
+        }
+        else if ((strcmp(argv[a], "--threads") == 0) && (a + 1 < argc) &&
+                 (atoi(argv[a + 1]) > 0))
+        {
+            threads = atoi(argv[++a]);
+        }
+        else if ((strcmp(argv[a], "--cache") == 0) && (a + 1 < argc) &&
+                 (atol(argv[a + 1]) > 0))
+        {
+            cacheSize = atol(argv[++a]);
+        }
+        else if (strcmp(argv[a], "--scaling") == 0)
+        {
+            scaling = true;
+        }
+        else if (strcmp(argv[a], "--fixed") == 0)
+        {
+            solver = SOLVER_FIXED;
+        }
+        else if (strcmp(argv[a], "--exhaustive") == 0)
+        {
+            solver = SOLVER_EXHAUSTIVE;
+        }
+        else if (strcmp(argv[a], "--points") == 0)
+        {
+            points = true;
+        }
+        else if ((strcmp(argv[a], "--sweep") == 0) && (a + 2 < argc) &&
+                 (atoi(argv[a + 1]) > 0) &&
+                 (atoi(argv[a + 2]) >= atoi(argv[a + 1])) &&
+                 (atol(argv[a + 2]) <= INT_MAX / 2))
+        {
+            mode = MODE_SWEEP;
+            sweepRange[0] = atoi(argv[++a]);
+            sweepRange[1] = atoi(argv[++a]);
+
+            // The reference is optional
+            if ((a + 1 < argc) && (strncmp(argv[a + 1], "--", 2) != 0))
+            {
+                inputPath = argv[++a];
+            }
+        }
+        else if ((strcmp(argv[a], "--serve") == 0) && (a + 1 < argc))
+        {
+            mode = MODE_SERVE;
+            inputPath = argv[++a];
+        }
+        else if ((strcmp(argv[a], "--curve") == 0) && (a + 2 < argc) &&
+                 (atoi(argv[a + 2]) > 0) &&
+                 (atol(argv[a + 2]) <= INT_MAX / 2))
+        {
+            mode = MODE_CURVE;
+            curveItem = argv[++a];
+            curveDemand = atoi(argv[++a]);
+
+            // The output file is optional
+            if ((a + 1 < argc) && (strncmp(argv[a + 1], "--", 2) != 0))
+            {
+                inputPath = argv[++a];
+            }
+        }
+        else if ((strcmp(argv[a], "--samples") == 0) && (a + 1 < argc) &&
+                 (atoi(argv[a + 1]) >= 0) &&
+                 (atoi(argv[a + 1]) <= CURVE_MAX_SAMPLES))
+        {
+            samples = atoi(argv[++a]);
+        }
+        else if ((strcmp(argv[a], "--offers") == 0) && (a + 1 < argc))
+        {
+            offersPath = argv[++a];
+        }
+        else if (strcmp(argv[a], "--binary") == 0)
+        {
+            binary = true;
+        }
+        else if ((strcmp(argv[a], "--bom") == 0) && (a + 1 < argc))
+        {
+            mode = MODE_BOM;
+            bomPath = argv[++a];
+
+            // The input file is optional ("-" also means stdin)
+            if ((a + 1 < argc) && (strncmp(argv[a + 1], "--", 2) != 0))
+            {
+                inputPath = argv[++a];
+            }
+        }
+        else if ((strcmp(argv[a], "--simulate") == 0) && (a + 1 < argc))
+        {
+            mode = MODE_SIMULATE;
+            inputPath = argv[++a];
+        }
+        else if ((strcmp(argv[a], "--demand") == 0) && (a + 1 < argc) &&
+                 (sscanf(argv[a + 1], "%lf:%lf", &demand.mean,
+                         &demand.stddev) == 2) &&
+                 (demand.mean >= 0) && (demand.stddev >= 0))
+        {
+            a++;
+        }
+        else if ((strcmp(argv[a], "--sample") == 0) && (a + 1 < argc))
+        {
+            samplePath = argv[++a];
+        }
+        else if ((strcmp(argv[a], "--lead") == 0) && (a + 1 < argc) &&
+                 (atoi(argv[a + 1]) >= 0) &&
+                 (atoi(argv[a + 1]) <= SIMULATION_MAX_LEAD))
+        {
+            lead = atoi(argv[++a]);
+        }
+        else if ((strcmp(argv[a], "--years") == 0) && (a + 1 < argc) &&
+                 (atol(argv[a + 1]) > 0))
+        {
+            years = atol(argv[++a]);
+        }
+        else if ((strcmp(argv[a], "--periods") == 0) && (a + 1 < argc) &&
+                 (atoi(argv[a + 1]) > 0))
+        {
+            periodsPerYear = atoi(argv[++a]);
+        }
+        else if ((strcmp(argv[a], "--seed") == 0) && (a + 1 < argc))
+        {
+            seed = strtoull(argv[++a], NULL, 10);
+        }
+        else if ((strcmp(argv[a], "--policy") == 0) && (a + 1 < argc))
+        {
+            policy_t policy;
+
+            if ((sscanf(argv[a + 1], "%d:%d", &policy.Q, &policy.R) != 2) ||
+                (policy.Q <= 0))
+            {
+                cerr << " -> Política '" << argv[a + 1];
+                cerr << "': se esperaba 'Q:R' con Q > 0.\n";
+                return 1;
+            }
+
+            policies.push_back(policy);
+            a++;
+        }
+        else if ((strcmp(argv[a], "--metrics") == 0) && (a + 1 < argc))
+        {
+            metricsFormat = argv[++a];
+        }
+        else if ((strcmp(argv[a], "--budget") == 0) && (a + 1 < argc) &&
+                 (atof(argv[a + 1]) > 0))
+        {
+            caps.value = atof(argv[++a]);
+        }
+        else if ((strcmp(argv[a], "--space") == 0) && (a + 1 < argc) &&
+                 (atof(argv[a + 1]) > 0))
+        {
+            caps.volume = atof(argv[++a]);
+        }
+        else if ((strcmp(argv[a], "--batch") == 0) ||
+                 (strcmp(argv[a], "--solve-all") == 0) ||
+                 (strcmp(argv[a], "--joint") == 0) ||
+                 (strcmp(argv[a], "--constrained") == 0) ||
+                 (strcmp(argv[a], "--stream") == 0) ||
+                 (strcmp(argv[a], "--lot-sizing") == 0) ||
+                 (strcmp(argv[a], "--suppliers") == 0))
+        {
+            mode = (strcmp(argv[a], "--batch") == 0) ? MODE_BATCH :
+                   (strcmp(argv[a], "--joint") == 0) ? MODE_JOINT :
+                   (strcmp(argv[a], "--stream") == 0) ? MODE_STREAM :
+                   (strcmp(argv[a], "--lot-sizing") == 0) ?
+                                                       MODE_LOT_SIZING :
+                   (strcmp(argv[a], "--suppliers") == 0) ?
+                                                       MODE_SUPPLIERS :
+                   (strcmp(argv[a], "--constrained") == 0) ?
+                                                       MODE_CONSTRAINED :
+                                                       MODE_SOLVE_ALL;
+
+            // The input file is optional ("-" also means stdin)
+            if ((a + 1 < argc) && (strncmp(argv[a + 1], "--", 2) != 0))
+            {
+                inputPath = argv[++a];
+            }
+        }
+        else
+        {
+            cerr << "Uso: " << argv[0];
+            cerr << " [--catalog FICHERO | --snapshot FICHERO]";
+            cerr << " [--compile FICHERO] [--export-static FICHERO]";
+            cerr << " [--batch [FICHERO]]";
+            cerr << " [--solve-all [FICHERO]] [--threads N] [--scaling]";
+            cerr << " [--serve SOCKET] [--cache N]";
+            cerr << " [--sweep DMIN DMAX [ID]] [--points] [--fixed]";
+            cerr << " [--exhaustive] [--joint [FICHERO]]";
+            cerr << " [--constrained [FICHERO]] [--budget VALOR]";
+            cerr << " [--space VOLUMEN] [--stream [FICHERO]]";
+            cerr << " [--simulate ID (--demand MEDIA:DESVIACION |";
+            cerr << " --sample FICHERO) [--lead DIAS] [--years N]";
+            cerr << " [--seed S] [--policy Q:R]...]";
+            cerr << " [--lot-sizing [FICHERO]] [--periods N]";
+            cerr << " [--bom BOM [FICHERO]]";
+            cerr << " [--curve ID D [FICHERO]] [--samples N] [--binary]";
+            cerr << " [--offers FICHERO] [--suppliers [FICHERO]]";
+            cerr << " [--metrics json|prometheus]\n";
+            return 1;
+        }
+    }
+
+    // Create catalog of references, from a file or from (references.h)
+    catalog_t catalog;
+    flat_catalog_t flat;
+    snapshot_t snapshot;
+    result_cache_t cache;
+    source_t source = { &catalog, &flat, NULL, 0, NULL, solver,
+                        detectScanIsa() };
+    string error;
+
+    if (snapshotPath != NULL)
+    {
+        if (openSnapshot(snapshotPath, &snapshot, &error) == false)
+        {
+            cerr << " -> Snapshot: " << error << ".\n";
+            return 1;
+        }
+
+        source.snapshot = &snapshot;
+        source.stamp = snapshot.header->stamp;
+    }
+#ifdef EOQ_STATIC_CATALOG
+    else if ((catalogPath == NULL) && (compilePath == NULL) &&
+             (exportPath == NULL))
+    {
+        // The references are constexpr data: nothing to load
+        source.catalog = NULL;
+        source.stamp = staticCatalogStamp(STATIC_REFERENCES);
+    }
+#endif
+    else if (catalogPath == NULL)
+    {
+        loadBuiltinCatalog(&catalog);
+    }
+    else if (loadCatalog(catalogPath, &catalog, &error) == false)
+    {
+        cerr << " -> Catálogo '" << catalogPath << "': " << error << ".\n";
+        return 1;
+    }
+
+    if ((source.snapshot == NULL) && (source.catalog == &catalog))
+    {
+        source.stamp = catalogStamp(&catalog);
+        buildFlatCatalog(&catalog, &flat);
+    }
+
+    // The offers go into the references of a text (or built-in) catalog
+    if ((offersPath != NULL) || (mode == MODE_SUPPLIERS))
+    {
+        if ((source.snapshot != NULL) || (source.catalog != &catalog))
+        {
+            cerr << " -> Ofertas: se cargan sobre un catálogo de texto ";
+            cerr << "o el incluido en el programa.\n";
+            return 1;
+        }
+
+        if ((offersPath != NULL) &&
+            (loadOffers(offersPath, &catalog, &error) == false))
+        {
+            cerr << " -> Ofertas '" << offersPath << "': " << error << ".\n";
+            return 1;
+        }
+    }
+
+    if (cacheSize > 0)
+    {
+        initCache(&cache, cacheSize);
+        source.cache = &cache;
+    }
+
+    // Compile the catalog into a binary snapshot and exit
+    if (compilePath != NULL)
+    {
+        if ((snapshotPath != NULL) ||
+            (compileSnapshot(&catalog, compilePath, &error) == false))
+        {
+            cerr << " -> Snapshot: " << ((snapshotPath != NULL) ?
+                    "se compila desde un catálogo de texto" : error) << ".\n";
+            return 1;
+        }
+
+        return 0;
+    }
+
+    // Write the catalog as a header of constexpr data and exit
+    if (exportPath != NULL)
+    {
+        if ((snapshotPath != NULL) ||
+            (exportStaticCatalog(&catalog, exportPath, &error) == false))
+        {
+            cerr << " -> Catálogo estático: " << ((snapshotPath != NULL) ?
+                    "se genera desde un catálogo de texto" : error) << ".\n";
+            return 1;
+        }
+
+        return 0;
+    }
+
+    // The other cost models are only known by the solver of policy.h
+    if (((flat.models).empty() == false) &&
+        ((solver != SOLVER_SEGMENTS) ||
+         ((mode != MODE_INTERACTIVE) && (mode != MODE_BATCH) &&
+          (mode != MODE_SOLVE_ALL) && (mode != MODE_SERVE) &&
+          (mode != MODE_BOM))))
+    {
+        cerr << " -> Modelo de costes: este modo solo resuelve referencias ";
+        cerr << "con el modelo original (sin 'incremental', 'freight' ";
+        cerr << "ni 'holding').\n";
+        return 1;
+    }
+
+    // Daemon mode: keep the catalog loaded and answer over a socket
+    if (mode == MODE_SERVE)
+    {
+        auto handle = [&](const char * line, size_t length, string * out)
+        {
+            answerRequest(&source, line, length, out);
+        };
+
+        bool served = runServer(inputPath, handle);
+
+        showMetrics(metricsFormat);
+
+        return served ? 0 : 1;
+    }
+
+    // Sweep mode: solve a whole range of demands and exit
+    if (mode == MODE_SWEEP)
+    {
+        string itemName = (inputPath != NULL) ? inputPath : "";
+
+        int status = runSweep(&source, sweepRange[0], sweepRange[1],
+                              itemName, points);
+
+        showMetrics(metricsFormat);
+
+        return status;
+    }
+
+    // Curve mode: write the cost curve of one reference and exit
+    if (mode == MODE_CURVE)
+    {
+        return runCurve(&source, curveItem, curveDemand, samples, binary,
+                        inputPath);
+    }
+
+    // Simulation mode: simulate the stock of one reference and exit
+    if (mode == MODE_SIMULATE)
+    {
+        vector<int> sample;
+
+        if (samplePath != NULL)
+        {
+            if (loadDemandSample(samplePath, &sample, &error) == false)
+            {
+                cerr << " -> Muestra '" << samplePath << "': " << error;
+                cerr << ".\n";
+                return 1;
+            }
+
+            demand.sample = &sample;
+        }
+        else if (demand.mean < 0)
+        {
+            cerr << " -> Simulación: falta --demand MEDIA:DESVIACION o ";
+            cerr << "--sample FICHERO.\n";
+            return 1;
+        }
+
+        return runSimulate(&source, inputPath, &demand, lead, policies,
+                           years, seed, threads);
+    }
+
+    // Non-interactive mode: solve a whole file of demands and exit
+    if ((mode == MODE_BATCH) || (mode == MODE_SOLVE_ALL) ||
+        (mode == MODE_JOINT) || (mode == MODE_CONSTRAINED) ||
+        (mode == MODE_STREAM) || (mode == MODE_LOT_SIZING) ||
+        (mode == MODE_BOM) || (mode == MODE_SUPPLIERS))
+    {
+        ios::sync_with_stdio(false);
+
+        ifstream file;
+        istream * input = &cin;
+
+        if ((inputPath != NULL) && (strcmp(inputPath, "-") != 0))
+        {
+            file.open(inputPath);
+
+            if (!file)
+            {
+                cerr << " -> No se puede abrir el fichero '";
+                cerr << inputPath << "'.\n";
+                return 1;
+            }
+
+            input = &file;
+        }
+
+        int errors = (mode == MODE_SOLVE_ALL) ?
+                     runSolveAll(*input, &source, threads, scaling) :
+                     (mode == MODE_JOINT) ? runJoint(*input, &source) :
+                     (mode == MODE_STREAM) ? runStream(*input, &source) :
+                     (mode == MODE_BOM) ? runBom(*input, &source, bomPath) :
+                     (mode == MODE_SUPPLIERS) ?
+                     runSuppliers(*input, &source, threads) :
+                     (mode == MODE_LOT_SIZING) ?
+                     runLotSizing(*input, &source, periodsPerYear, threads) :
+                     (mode == MODE_CONSTRAINED) ?
+                     runConstrained(*input, &source, &caps, threads) :
+                     runBatch(*input, &source);
+
+        showCacheStats(&source);
+        showMetrics(metricsFormat);
+
+        if (source.solver == SOLVER_EXHAUSTIVE)
+        {
+            cerr << "exhaustive: " << scanIsaName(source.isa) << "\n";
+        }
+
+        return (errors == 0) ? 0 : 1;
+    }
 
     // Create the rest of the necessary variables
     string itemName;
     bool referenceIsValid = false;
-    unordered_map<string, reference_t>::iterator searched;
+    tiers_t searched;
     int demanda;
     bool demandIsValid = false;
  
@@ -178,32 +2544,7 @@ int main(void)
     for(;;)
     {
         // Show references table to user
-        cout << "+--------------------------------------------------------------+" << endl;
-        cout << "| " << BOLD << "TABLA DE REFERENCIAS" << RESET_COLOR;
-        cout << "                                         |" << endl;
-        cout << "+-------------+------------------------------------------------+" << endl;
-        cout << "| " << BOLD << "ID" << RESET_COLOR;
-        cout << "          | " << BOLD << "Descripción" << RESET_COLOR;
-        cout << "                                    |" << endl;
-        cout << "+-------------+------------------------------------------------+" << endl;
-        cout << "| NVLS745     | Envase de miel  1 kg liso V720                 |" << endl;
-        cout << "| 110212      | Tapa TO 77mm dorada pasteurizable              |" << endl;
-        cout << "| 260024045   | Rollo de 500 etiquetas (de cualquier tipo)     |" << endl;
-        cout << "| 260024046   | Rollo de 1000 etiquetas de precinto para botes |" << endl;
-        cout << "| 303117      | Caja de cartón para 12 tarros V720             |" << endl;
-        cout << "| 110102      | Envase de 0,5 kg celdilla                      |" << endl;
-        cout << "| 110207      | Tapa TO 66 mm dorada pasteurizable             |" << endl;
-        cout << "| CAJ1205     | Caja de cartón 12 frascos miel 1/2 kg          |" << endl;
-        cout << "| STO69015    | Topacio 20 ml para jalea PP28 sin tapón        |" << endl;
-        cout << "| tapon-PP28  | Tapón PP28 para topacios                       |" << endl;
-        cout << "| CUDOS/1000  | Cuchara para jalea real 1000 ud.               |" << endl;
-        cout << "| 30ml-DIN18  | Topacio ámbar para propóleos 30 ml DIN18       |" << endl;
-        cout << "| tapon-spray | Tapón spray de envase para propoleo            |" << endl;
-        cout << "| caja_01     | Embalajes para jalea real                      |" << endl;
-        cout << "| caja_02     | Caja de cartón para 24 de jalea real           |" << endl;
-        cout << "| caja_03     | Embalajes para propóleo                        |" << endl;
-        cout << "| caja_04     | Caja de cartón para 24 de propóleo             |" << endl;
-        cout << "+-------------+------------------------------------------------+" << endl;
+        showReferencesTable(&source);
         cout << " *Para copiar una referencia usar CTRL + SHIFT + C                 " << endl;
         cout << " *Para pegar usar CTRL + SHIFT + V                                 " << endl;
 
@@ -214,11 +2555,8 @@ int main(void)
             cout << "(escribir ID): " << RESET_COLOR;
             cin >> itemName;
             
-            // Find reference
-            searched = referencesDict.find(itemName);
-            
-            // Check if the key is not present
-            if (searched == referencesDict.end())
+            // Find reference, checking if the key is not present
+            if (findTiers(&source, itemName, &searched) == false)
             {
                 // If not, retry
                 cout << RED << " -> La referencia '" << itemName;
@@ -258,7 +2596,7 @@ int main(void)
         } while (demandIsValid == false);
         
         // Calculate and display the Q*
-        showOptimalQ(demanda, &(searched->second));
+        showOptimalQ(demanda, &searched);
         
         // Wait for the user to press any key
         cout << BOLD << " -> Presiona ENTER para continuar,";
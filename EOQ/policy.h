@@ -0,0 +1,331 @@
+/**
+ * @file     policy.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Solver of the optimal Q for other cost models than the one of
+ *           the original program, as a template over three policies:
+ *
+ *             Pricing   all_units_pricing_t     ca of the tier of Q
+ *                       incremental_pricing_t   each unit in its tier
+ *             Issue     tiered_issue_t          ce of the tier of Q
+ *                       freight_issue_t         ce + freight · Q
+ *             Holding   percentage_holding_t    % of the price paid
+ *                       absolute_holding_t      cost per unit and year
+ *
+ *           Inside a segment of eoq.h (fixed ca and ce tiers) every
+ *           policy is a line in Q: an order of Q units costs a + b·Q to
+ *           buy and c + d·Q to issue, and its stock costs e + f·Q a year.
+ *           So the annual cost is
+ *
+ *             CT(Q) = (D·b + D·d + e) + D·(a + c)/Q + f·Q
+ *
+ *           convex in the segment, and solved in closed form as in
+ *           segmentOptimalQ(). Each combination of policies is its own
+ *           instance of solvePolicyQ(), with the policies inlined: the
+ *           model is chosen once per reference, in solveModelQ(), and
+ *           never inside the loop. The original combination is the
+ *           solveOptimalQ() of eoq.h, so its results do not change.
+ */
+
+#ifndef POLICY_H
+#define POLICY_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "types.h"
+#include "eoq.h"
+
+#include <math.h>
+
+using namespace std;
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef struct
+{
+    double fixed;   // Part that does not depend on Q
+    double unit;    // Part per unit of Q
+
+} cost_line_t;
+
+typedef solution_t (*policy_solver_t)(int D, const tiers_t * tiers);
+
+/******************************************************************************/
+/*!
+ * @brief  Pricing of the original program: every unit of the order is
+ *         bought at the ca of the tier that contains Q.
+ */
+struct all_units_pricing_t
+{
+    static inline cost_line_t line(const tiers_t * tiers, int i)
+    {
+        return { 0.0, (double)(tiers->ca_list[i]).value };
+    }
+};
+
+/******************************************************************************/
+/*!
+ * @brief  Incremental discounts: the units below each breakpoint keep the
+ *         ca of their own tier, so an order of Q units in tier i costs
+ *         the full lower tiers plus ca_i for each unit from min_unit_i.
+ */
+struct incremental_pricing_t
+{
+    static inline cost_line_t line(const tiers_t * tiers, int i)
+    {
+        const cost_t * ca = tiers->ca_list;
+        double lower = 0.0;
+
+        for (int k = 0; k < i; k++)
+        {
+            lower += ca[k].value * (double)(ca[k + 1].min_unit -
+                                            ca[k].min_unit);
+        }
+
+        return { lower - ca[i].value * (double)(ca[i].min_unit - 1),
+                 (double)ca[i].value };
+    }
+};
+
+/******************************************************************************/
+/*!
+ * @brief  Issue of the original program: the ce of the tier of Q is paid
+ *         once per order.
+ */
+struct tiered_issue_t
+{
+    static inline cost_line_t line(const tiers_t * tiers, int j)
+    {
+        return { (double)(tiers->ce_list[j]).value, 0.0 };
+    }
+};
+
+/******************************************************************************/
+/*!
+ * @brief  Fixed plus variable freight: the ce of the tier of Q per order
+ *         and cost_model_t::freight per unit ordered.
+ */
+struct freight_issue_t
+{
+    static inline cost_line_t line(const tiers_t * tiers, int j)
+    {
+        return { (double)(tiers->ce_list[j]).value,
+                 (double)tiers->model->freight };
+    }
+};
+
+/******************************************************************************/
+/*!
+ * @brief  Holding of the original program: a year of stock costs
+ *         cp_percentage of the price paid for it, and the average stock
+ *         is half an order.
+ */
+struct percentage_holding_t
+{
+    static inline cost_line_t line(const tiers_t * tiers,
+                                   const cost_line_t & purchase)
+    {
+        double half = tiers->cp_percentage / 2.0;
+
+        return { half * purchase.fixed, half * purchase.unit };
+    }
+};
+
+/******************************************************************************/
+/*!
+ * @brief  Absolute holding: a year of stock costs cost_model_t::
+ *         holding_cost per unit, whatever its price.
+ */
+struct absolute_holding_t
+{
+    static inline cost_line_t line(const tiers_t * tiers,
+                                   const cost_line_t & purchase)
+    {
+        (void)purchase;
+
+        return { 0.0, tiers->model->holding_cost / 2.0 };
+    }
+};
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that finds the integer Q with the lowest CT(Q) = c0 +
+ *         c1/Q + c2·Q inside a segment, as segmentOptimalQ() does.
+ * @param  c0  Part of CT that does not depend on Q.
+ * @param  c1  Part of CT divided by Q.
+ * @param  c2  Part of CT multiplied by Q (not negative).
+ * @param  seg  Segment to minimise.
+ * @return Best integer Q of the segment.
+ */
+inline int policyOptimalQ(double c0, double c1, double c2,
+                          const segment_t * seg)
+{
+    double q;
+
+    if ((c1 > 0) && (c2 > 0))
+    {
+        q = sqrt(c1 / c2);
+    }
+    else
+    {
+        // CT is monotonic: decreasing with no holding cost, else increasing
+        q = (c1 > 0) ? seg->hi : seg->lo;
+    }
+
+    // Clamp the continuous optimum to the segment bounds
+    if (q < seg->lo) q = seg->lo;
+    if (q > seg->hi) q = seg->hi;
+
+    int q_floor = (int)floor(q);
+    int q_ceil = (q_floor < seg->hi) ? (q_floor + 1) : q_floor;
+
+    if (c0 + c1 / q_ceil + c2 * q_ceil < c0 + c1 / q_floor + c2 * q_floor)
+    {
+        return q_ceil;
+    }
+
+    return q_floor;
+
+}   /* policyOptimalQ() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that calculates the Q* of a reference with a cost model
+ *         made of one policy of each kind (see the top of the file). The
+ *         costs are computed in double: ca is the average price paid per
+ *         unit and cp the cost of a unit in stock for a year, so that
+ *         CA = ca·D, CE = ce·D/Q and CP = cp·Q/2 as in evaluateQ().
+ * @param  D  This number indicates the annual demand for the reference.
+ * @param  tiers  Tiers of the reference (with its model, if a policy
+ *                reads it).
+ * @return Costs of the optimal order (Q = 0 if D is not positive).
+ */
+template <typename Pricing, typename Issue, typename Holding>
+inline solution_t solvePolicyQ(int D, const tiers_t * tiers)
+{
+    solution_t best = { 0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, MAXFLOAT };
+
+    METRIC_SOLVE();
+
+    if ((D <= 0) || (tiers->ca_count == 0) || (tiers->ce_count == 0))
+    {
+        return best;
+    }
+
+    double min_CT = HUGE_VAL;
+    segment_t seg = { 0, 0, 0, 0 };
+
+    while (nextSegment(tiers, D * 2, &seg))
+    {
+        cost_line_t purchase = Pricing::line(tiers, seg.i);
+        cost_line_t issue = Issue::line(tiers, seg.j);
+        cost_line_t holding = Holding::line(tiers, purchase);
+        double c0 = D * (purchase.unit + issue.unit) + holding.fixed;
+        double c1 = D * (purchase.fixed + issue.fixed);
+        double c2 = holding.unit;
+        int q = policyOptimalQ(c0, c1, c2, &seg);
+        double CT = c0 + c1 / q + c2 * q;
+
+        METRIC_ADD(segments, 1);
+
+        // The first segment wins a tie, as in the exhaustive scan
+        if (CT < min_CT)
+        {
+            double CP = holding.fixed + holding.unit * q;
+
+            min_CT = CT;
+            best.Q = q;
+            best.ca = (float)(purchase.fixed / q + purchase.unit);
+            best.ce = (float)(issue.fixed + issue.unit * q);
+            best.cp = (float)(CP * 2.0 / q);
+            best.CA = (float)(D * (purchase.fixed / q + purchase.unit));
+            best.CE = (float)(D * (issue.fixed / q + issue.unit));
+            best.CP = (float)CP;
+            best.CT = (float)CT;
+        }
+    }
+
+    return best;
+
+}   /* solvePolicyQ() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that calculates the Q* of the original model: the
+ *         solveOptimalQ() of eoq.h, whose results are the ones of the
+ *         exhaustive scan in float.
+ * @param  D  This number indicates the annual demand for the reference.
+ * @param  tiers  Tiers of the reference.
+ * @return Costs of the optimal order (Q = 0 if D is not positive).
+ */
+template <>
+inline solution_t solvePolicyQ<all_units_pricing_t, tiered_issue_t,
+                               percentage_holding_t>(int D,
+                                                     const tiers_t * tiers)
+{
+    return solveOptimalQ(D, tiers);
+
+}   /* solvePolicyQ() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that calculates the Q* of a reference with the cost
+ *         model of its tiers: the instance of solvePolicyQ() for that
+ *         model is chosen once, and solves the whole reference.
+ * @param  D  This number indicates the annual demand for the reference.
+ * @param  tiers  Tiers of the reference (model NULL for the original).
+ * @return Costs of the optimal order (Q = 0 if D is not positive).
+ */
+inline solution_t solveModelQ(int D, const tiers_t * tiers)
+{
+    // Indexed by pricing_t, issue_t and holding_t
+    static const policy_solver_t SOLVERS[2][2][2] =
+    {
+        {
+            {
+                solvePolicyQ<all_units_pricing_t, tiered_issue_t,
+                             percentage_holding_t>,
+                solvePolicyQ<all_units_pricing_t, tiered_issue_t,
+                             absolute_holding_t>
+            },
+            {
+                solvePolicyQ<all_units_pricing_t, freight_issue_t,
+                             percentage_holding_t>,
+                solvePolicyQ<all_units_pricing_t, freight_issue_t,
+                             absolute_holding_t>
+            }
+        },
+        {
+            {
+                solvePolicyQ<incremental_pricing_t, tiered_issue_t,
+                             percentage_holding_t>,
+                solvePolicyQ<incremental_pricing_t, tiered_issue_t,
+                             absolute_holding_t>
+            },
+            {
+                solvePolicyQ<incremental_pricing_t, freight_issue_t,
+                             percentage_holding_t>,
+                solvePolicyQ<incremental_pricing_t, freight_issue_t,
+                             absolute_holding_t>
+            }
+        }
+    };
+
+    const cost_model_t * model = tiers->model;
+
+    if (originalModel(model))
+    {
+        return solveOptimalQ(D, tiers);
+    }
+
+    return SOLVERS[model->pricing][model->issue][model->holding](D, tiers);
+
+}   /* solveModelQ() */
+
+#endif /* POLICY_H */
+
+/*** end of file ***/
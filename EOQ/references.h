@@ -9,30 +9,13 @@
 
 //-----[ INCLUDES ]-----------------------------------------------------------//
 
+#include "types.h"
+
 #include <iostream>
 #include <vector>
 
 using namespace std;
 
-//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
-
-typedef struct
-{
-    int min_unit;
-    float value;
-    
-} cost_t;
-
-typedef struct
-{
-    string id;
-    string description;
-    vector<cost_t> ca_list;
-    vector<cost_t> ce_list;
-    float cp_percentage;
-
-} reference_t;
-
 //-----[ REFERENCES ]---------------------------------------------------------//
 
 /*--------------------------------------------------+
@@ -70,7 +53,11 @@ reference_t R_NVLS745 =
         { 4815, 227.48 }
     },
     // Cost of ownership (% of Acquisition Cost)
-    0.16
+    0.16,
+    // Other suppliers (see suppliers.h)
+    {},
+    // Cost model (see policy.h)
+    {}
 };
 
 /*----------------------------------------------------+
@@ -101,7 +88,11 @@ reference_t R_110212 =
         { 5001,  16.90 }
     },
     // Cost of ownership (% of Acquisition Cost)
-    0.10
+    0.10,
+    // Other suppliers (see suppliers.h)
+    {},
+    // Cost model (see policy.h)
+    {}
 };
 
 /*----------------------------------------------------------------+
@@ -123,7 +114,11 @@ reference_t R_260024045 =
         {    1,   3.95 }
     },
     // Cost of ownership (% of Acquisition Cost)
-    0.09
+    0.09,
+    // Other suppliers (see suppliers.h)
+    {},
+    // Cost model (see policy.h)
+    {}
 };
 
 /*--------------------------------------------------------------------+
@@ -145,7 +140,11 @@ reference_t R_260024046 =
         {    1,   3.95 }
     },
     // Cost of ownership (% of Acquisition Cost)
-    0.09
+    0.09,
+    // Other suppliers (see suppliers.h)
+    {},
+    // Cost model (see policy.h)
+    {}
 };
 
 /*-----------------------------------------------------+
@@ -181,7 +180,11 @@ reference_t R_303117 =
         { 13000, 227.48 }
     },
     // Cost of ownership (% of Acquisition Cost)
-    0.14
+    0.14,
+    // Other suppliers (see suppliers.h)
+    {},
+    // Cost model (see policy.h)
+    {}
 };
 
 /*--------------------------------------------+
@@ -220,7 +223,11 @@ reference_t R_110102 =
         { 4483, 227.48 }
     },
     // Cost of ownership (% of Acquisition Cost)
-    0.15
+    0.15,
+    // Other suppliers (see suppliers.h)
+    {},
+    // Cost model (see policy.h)
+    {}
 };
 
 /*-----------------------------------------------------+
@@ -250,7 +257,11 @@ reference_t R_110207 =
         { 3875,  14.90 }
     },
     // Cost of ownership (% of Acquisition Cost)
-    0.10
+    0.10,
+    // Other suppliers (see suppliers.h)
+    {},
+    // Cost model (see policy.h)
+    {}
 };
 
 /*---------------------------------------------------------+
@@ -286,7 +297,11 @@ reference_t R_CAJ1205 =
         { 9715, 286.77 }
     },
     // Cost of ownership (% of Acquisition Cost)
-    0.13
+    0.13,
+    // Other suppliers (see suppliers.h)
+    {},
+    // Cost model (see policy.h)
+    {}
 };
 
 /*------------------------------------------------------------+
@@ -309,7 +324,11 @@ reference_t R_STO69015 =
         { 1, 3.95 }
     },
     // Cost of ownership (% of Acquisition Cost)
-    0.13
+    0.13,
+    // Other suppliers (see suppliers.h)
+    {},
+    // Cost model (see policy.h)
+    {}
 };
 
 /*-----------------------------------------------+
@@ -331,7 +350,11 @@ reference_t R_taponPP28 =
         { 1, 3.95 }
     },
     // Cost of ownership (% of Acquisition Cost)
-    0.10
+    0.10,
+    // Other suppliers (see suppliers.h)
+    {},
+    // Cost model (see policy.h)
+    {}
 };
 
 /*------------------------------------------------------+
@@ -356,7 +379,11 @@ reference_t R_CUDOS1000 =
         { 16000, 6.95 }
     },
     // Cost of ownership (% of Acquisition Cost)
-    0.09
+    0.09,
+    // Other suppliers (see suppliers.h)
+    {},
+    // Cost model (see policy.h)
+    {}
 };
 
 /*--------------------------------------------------------------+
@@ -382,7 +409,11 @@ reference_t R_30mlDIN18 =
         { 16000, 6.95 }
     },
     // Cost of ownership (% of Acquisition Cost)
-    0.13
+    0.13,
+    // Other suppliers (see suppliers.h)
+    {},
+    // Cost model (see policy.h)
+    {}
 };
 
 /*-----------------------------------------------------------+
@@ -405,7 +436,11 @@ reference_t R_taponspray =
         { 66, 0.00 }
     },
     // Cost of ownership (% of Acquisition Cost)
-    0.08
+    0.08,
+    // Other suppliers (see suppliers.h)
+    {},
+    // Cost model (see policy.h)
+    {}
 };
 
 /*---------------------------------------------+
@@ -427,7 +462,11 @@ reference_t R_caja_01 =
         {  1, 3.95 }
     },
     // Cost of ownership (% of Acquisition Cost)
-    0.10
+    0.10,
+    // Other suppliers (see suppliers.h)
+    {},
+    // Cost model (see policy.h)
+    {}
 };
 
 /*--------------------------------------------------------+
@@ -449,7 +488,11 @@ reference_t R_caja_02 =
         { 1, 3.95 }
     },
     // Cost of ownership (% of Acquisition Cost)
-    0.12
+    0.12,
+    // Other suppliers (see suppliers.h)
+    {},
+    // Cost model (see policy.h)
+    {}
 };
 
 /*-------------------------------------------+
@@ -471,7 +514,11 @@ reference_t R_caja_03 =
         { 1, 3.95 }
     },
     // Cost of ownership (% of Acquisition Cost)
-    0.10
+    0.10,
+    // Other suppliers (see suppliers.h)
+    {},
+    // Cost model (see policy.h)
+    {}
 };
 
 /*------------------------------------------------------+
@@ -493,7 +540,24 @@ reference_t R_caja_04 =
         { 1, 3.95 }
     },
     // Cost of ownership (% of Acquisition Cost)
-    0.12
+    0.12,
+    // Other suppliers (see suppliers.h)
+    {},
+    // Cost model (see policy.h)
+    {}
+};
+
+//-----[ LIST OF REFERENCES ]-------------------------------------------------//
+
+reference_t * R_ALL[] =
+{
+    &R_NVLS745,    &R_110212,    &R_260024045, &R_260024046,
+    &R_303117,     &R_110102,    &R_110207,    &R_CAJ1205,
+    &R_STO69015,   &R_taponPP28, &R_CUDOS1000, &R_30mlDIN18,
+    &R_taponspray, &R_caja_01,   &R_caja_02,   &R_caja_03,
+    &R_caja_04
 };
 
+#define R_ALL_COUNT (sizeof(R_ALL) / sizeof(R_ALL[0]))
+
 /*** end of file ***/
\ No newline at end of file
@@ -0,0 +1,76 @@
+/**
+ * @file     render.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Terminal rendering of the results of the solver (eoq.h).
+ */
+
+#ifndef RENDER_H
+#define RENDER_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "eoq.h"
+
+#include <iostream>
+#include <iomanip> // Para std::setw
+
+using namespace std;
+
+//-----[ COLORS ]-------------------------------------------------------------//
+
+#define RESET_COLOR	"\e[0m"
+#define BOLD        "\e[1;37m"
+#define CYAN_T   	"\e[1;36m"
+#define YELLOW   	"\e[1;33m"
+#define WHITE       "\e[1;37m"
+#define RED         "\e[0;31m"
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that shows a table with the values ​​of ce, ca,
+ *         cp, Q*, CA, CE, CP and CT of a solution.
+ * @param  optimal  Solution returned by solveOptimalQ().
+ * @return void
+ */
+inline void showSolution(const solution_t & optimal)
+{
+    cout << endl;
+
+    // Set the format to display three decimal precision
+    cout << fixed << setprecision(3);
+
+    cout << "+-------------------+" << endl;
+    cout << "| ca: " << setw(9) << optimal.ca << " €   |" << endl;
+    cout << "| ce: " << setw(9) << optimal.ce << " €   |" << endl;
+    cout << "| cp: " << setw(9) << optimal.cp << " €   |" << endl;
+    cout << "|-------------------|" << endl;
+
+    // Set the format to display zero decimal precision
+    cout << fixed << setprecision(0);
+
+    cout << "| " << BOLD << "Q*: " << setw(9) << optimal.Q;
+    cout << " ud. " << RESET_COLOR << "|" << endl;
+    cout << "|-------------------|" << endl;
+
+    // Set the format to display two decimal precision
+    cout << fixed << setprecision(2);
+
+    cout << "| CA: " << setw(9) << optimal.CA << " €   |" << endl;
+    cout << "| CE: " << setw(9) << optimal.CE << " €   |" << endl;
+    cout << "| CP: " << setw(9) << optimal.CP << " €   |" << endl;
+    cout << "|-------------------|" << endl;
+    cout << "| CT: " << setw(9) << optimal.CT << " €   |" << endl;
+    cout << "+-------------------+" << endl;
+
+    cout << endl;
+
+}   /* showSolution() */
+
+#endif /* RENDER_H */
+
+/*** end of file ***/
@@ -0,0 +1,517 @@
+/**
+ * @file     server.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Single-threaded epoll event loop that serves a line-based
+ *           protocol over a Unix domain socket.
+ *
+ *           Each request is one line ending in '\n' and gets exactly
+ *           one response line, in the same order. Clients may pipeline
+ *           (send many requests without waiting): every complete line
+ *           in the input buffer is answered, and the responses of one
+ *           read are sent together with a single write. A client that
+ *           does not read its responses is not read either once
+ *           SERVER_MAX_OUTPUT bytes are waiting for it.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include <errno.h>
+#include <fcntl.h>
+#include <functional>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <unordered_map>
+
+using namespace std;
+
+//-----[ CONSTANTS ]----------------------------------------------------------//
+
+// Events handled by each call to epoll_wait()
+#define SERVER_MAX_EVENTS 64
+
+// Bytes read from a connection at once
+#define SERVER_READ_SIZE (1 << 16)
+
+// Longest request line accepted before the connection is closed
+#define SERVER_MAX_LINE 4096
+
+// Pending responses of a connection above which its requests are not read
+#define SERVER_MAX_OUTPUT (1 << 20)
+
+// Milliseconds the listener waits, out of descriptors, before accepting again
+#define SERVER_RETRY_MS 100
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef struct
+{
+    string in;          // Bytes read that do not form a full line yet
+    string out;         // Responses that could not be written yet
+    uint32_t events;    // Events registered in epoll
+    bool closing;       // The peer has closed its side
+
+} connection_t;
+
+//-----[ GLOBALS ]------------------------------------------------------------//
+
+// Set by SIGINT/SIGTERM to leave the event loop
+static volatile sig_atomic_t serverStop = 0;
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Signal handler that asks the event loop to stop.
+ * @param  signal  Number of the signal.
+ * @return void
+ */
+inline void stopServer(int signal)
+{
+    (void)signal;
+    serverStop = 1;
+
+}   /* stopServer() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that writes as much of the pending output as the
+ *         socket takes, and enables EPOLLOUT only while some is left
+ *         (and EPOLLIN only while the peer is still sending and less
+ *         than SERVER_MAX_OUTPUT bytes are pending).
+ * @param  epoll  epoll instance.
+ * @param  fd  Socket of the connection.
+ * @param  conn  Connection.
+ * @return false if the connection failed and must be closed.
+ */
+inline bool flushConnection(int epoll, int fd, connection_t * conn)
+{
+    size_t sent = 0;
+
+    while (sent < conn->out.size())
+    {
+        ssize_t n = send(fd, conn->out.data() + sent, conn->out.size() - sent,
+                         MSG_NOSIGNAL);
+
+        if (n < 0)
+        {
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+            {
+                break;
+            }
+
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return false;
+        }
+
+        sent += n;
+    }
+
+    conn->out.erase(0, sent);
+
+    bool reading = (conn->closing == false) &&
+                   (conn->out.size() < SERVER_MAX_OUTPUT);
+    uint32_t events = (reading ? (uint32_t)EPOLLIN : 0u) |
+                      (conn->out.empty() ? 0u : (uint32_t)EPOLLOUT);
+
+    if (events != conn->events)
+    {
+        struct epoll_event event;
+
+        event.events = events;
+        event.data.fd = fd;
+
+        if (epoll_ctl(epoll, EPOLL_CTL_MOD, fd, &event) != 0)
+        {
+            return false;
+        }
+
+        conn->events = events;
+    }
+
+    return true;
+
+}   /* flushConnection() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that reads everything available on a connection and
+ *         answers every complete line with handle(), until the pending
+ *         output reaches SERVER_MAX_OUTPUT bytes (the rest stays in the
+ *         socket until the client reads its responses).
+ * @param  fd  Socket of the connection.
+ * @param  conn  Connection.
+ * @param  handle  Appends the response to a request line to the output.
+ * @return false if the peer closed the connection or it failed.
+ */
+inline bool readConnection(int fd, connection_t * conn,
+                           const function<void(const char *, size_t,
+                                               string *)> & handle)
+{
+    char block[SERVER_READ_SIZE];
+
+    for (;;)
+    {
+        if (conn->out.size() >= SERVER_MAX_OUTPUT)
+        {
+            return true;
+        }
+
+        ssize_t n = recv(fd, block, sizeof(block), 0);
+
+        if (n == 0)
+        {
+            return false;
+        }
+
+        if (n < 0)
+        {
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+            {
+                return true;
+            }
+
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return false;
+        }
+
+        conn->in.append(block, n);
+
+        // Answer every complete line, in order
+        size_t start = 0;
+        size_t end;
+
+        while ((end = conn->in.find('\n', start)) != string::npos)
+        {
+            size_t length = end - start;
+
+            if ((length > 0) && (conn->in[end - 1] == '\r'))
+            {
+                length--;
+            }
+
+            handle(conn->in.data() + start, length, &(conn->out));
+            start = end + 1;
+        }
+
+        conn->in.erase(0, start);
+
+        if (conn->in.size() > SERVER_MAX_LINE)
+        {
+            return false;
+        }
+    }
+
+}   /* readConnection() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that makes room for the socket at a path: nothing to do
+ *         if the path is free, and a stale socket (one that no server
+ *         accepts on) is removed. Anything else is left alone.
+ * @param  address  Address of the socket.
+ * @return false if the path is in use and the server cannot start.
+ */
+inline bool freeSocketPath(const struct sockaddr_un * address)
+{
+    const char * path = address->sun_path;
+    struct stat info;
+
+    if (lstat(path, &info) != 0)
+    {
+        if (errno == ENOENT)
+        {
+            return true;
+        }
+
+        fprintf(stderr, " -> No se puede usar '%s': %s.\n", path,
+                strerror(errno));
+        return false;
+    }
+
+    if (S_ISSOCK(info.st_mode) == false)
+    {
+        fprintf(stderr, " -> '%s' existe y no es un socket.\n", path);
+        return false;
+    }
+
+    // A socket that still accepts connections belongs to a live server
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    bool live = (probe >= 0) &&
+                (connect(probe, (const struct sockaddr *)address,
+                         sizeof(*address)) == 0);
+
+    if (probe >= 0)
+    {
+        close(probe);
+    }
+
+    if (live)
+    {
+        fprintf(stderr, " -> Ya hay un servidor escuchando en '%s'.\n", path);
+        return false;
+    }
+
+    if (unlink(path) != 0)
+    {
+        fprintf(stderr, " -> No se puede borrar el socket '%s': %s.\n", path,
+                strerror(errno));
+        return false;
+    }
+
+    return true;
+
+}   /* freeSocketPath() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that accepts every pending connection and adds it to
+ *         epoll. Out of descriptors (EMFILE or ENFILE), the spare one is
+ *         closed to accept and close each pending connection, so that
+ *         the listener does not stay ready forever; if the spare cannot
+ *         be opened again, the listener is left out of epoll for a while
+ *         (see SERVER_RETRY_MS).
+ * @param  epoll  epoll instance.
+ * @param  listener  Listening socket.
+ * @param  spare  Descriptor kept open for when there are no others left.
+ * @param  connections  Open connections, by socket.
+ * @return false if the listener was left out of epoll.
+ */
+inline bool acceptConnections(int epoll, int listener, int * spare,
+                              unordered_map<int, connection_t> * connections)
+{
+    while (true)
+    {
+        int client = accept4(listener, NULL, NULL, SOCK_NONBLOCK);
+
+        if (client >= 0)
+        {
+            struct epoll_event event;
+
+            event.events = EPOLLIN;
+            event.data.fd = client;
+
+            if (epoll_ctl(epoll, EPOLL_CTL_ADD, client, &event) != 0)
+            {
+                close(client);
+                continue;
+            }
+
+            (*connections)[client] = { "", "", EPOLLIN, false };
+            continue;
+        }
+
+        if ((errno == EINTR) || (errno == ECONNABORTED))
+        {
+            continue;
+        }
+
+        if ((errno != EMFILE) && (errno != ENFILE))
+        {
+            return true;
+        }
+
+        if (*spare >= 0)
+        {
+            close(*spare);
+            client = accept4(listener, NULL, NULL, SOCK_NONBLOCK);
+
+            if (client >= 0)
+            {
+                close(client);
+            }
+
+            *spare = open("/dev/null", O_RDONLY | O_CLOEXEC);
+
+            // EMFILE comes before EAGAIN: none may have been pending
+            if (client < 0)
+            {
+                return true;
+            }
+
+            continue;
+        }
+
+        epoll_ctl(epoll, EPOLL_CTL_DEL, listener, NULL);
+        return false;
+    }
+
+}   /* acceptConnections() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that listens on a Unix domain socket and serves
+ *         requests until SIGINT or SIGTERM. A stale socket file at the
+ *         same path is replaced (see freeSocketPath()), and the file is
+ *         removed on exit.
+ * @param  path  Path of the socket.
+ * @param  handle  Appends the response to a request line to the output.
+ * @return false if the socket could not be created or the loop failed.
+ */
+inline bool runServer(const char * path,
+                      const function<void(const char *, size_t,
+                                          string *)> & handle)
+{
+    struct sockaddr_un address;
+
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, " -> La ruta del socket '%s' es demasiado larga.\n",
+                path);
+        return false;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    if (freeSocketPath(&address) == false)
+    {
+        return false;
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+
+    if ((listener < 0) ||
+        (bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0) ||
+        (listen(listener, SOMAXCONN) != 0))
+    {
+        fprintf(stderr, " -> No se puede escuchar en '%s': %s.\n", path,
+                strerror(errno));
+        return false;
+    }
+
+    int epoll = epoll_create1(0);
+    struct epoll_event event;
+
+    event.events = EPOLLIN;
+    event.data.fd = listener;
+
+    if ((epoll < 0) || (epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event) != 0))
+    {
+        fprintf(stderr, " -> No se puede crear el bucle de eventos: %s.\n",
+                strerror(errno));
+
+        if (epoll >= 0)
+        {
+            close(epoll);
+        }
+
+        close(listener);
+        unlink(path);
+        return false;
+    }
+
+    signal(SIGINT, stopServer);
+    signal(SIGTERM, stopServer);
+
+    unordered_map<int, connection_t> connections;
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    int spare = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    bool listening = true;
+    bool served = true;
+
+    while (serverStop == 0)
+    {
+        int ready = epoll_wait(epoll, events, SERVER_MAX_EVENTS,
+                               listening ? -1 : SERVER_RETRY_MS);
+
+        // Out of descriptors a while ago: listen again
+        if (listening == false)
+        {
+            if (spare < 0)
+            {
+                spare = open("/dev/null", O_RDONLY | O_CLOEXEC);
+            }
+
+            listening = (epoll_ctl(epoll, EPOLL_CTL_ADD, listener,
+                                   &event) == 0);
+        }
+
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            fprintf(stderr, " -> Error en epoll_wait(): %s.\n",
+                    strerror(errno));
+            served = false;
+            break;
+        }
+
+        for (int e = 0; e < ready; e++)
+        {
+            int fd = events[e].data.fd;
+
+            // New connections
+            if (fd == listener)
+            {
+                listening = acceptConnections(epoll, listener, &spare,
+                                              &connections);
+                continue;
+            }
+
+            connection_t & conn = connections[fd];
+
+            if ((conn.closing == false) &&
+                (events[e].events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+            {
+                conn.closing = (readConnection(fd, &conn, handle) == false);
+            }
+
+            // Keep a closed peer until all of its responses are sent
+            bool open = flushConnection(epoll, fd, &conn);
+
+            if ((open == false) || (conn.closing && conn.out.empty()))
+            {
+                epoll_ctl(epoll, EPOLL_CTL_DEL, fd, NULL);
+                close(fd);
+                connections.erase(fd);
+            }
+        }
+    }
+
+    for (auto & item : connections)
+    {
+        close(item.first);
+    }
+
+    if (spare >= 0)
+    {
+        close(spare);
+    }
+
+    close(epoll);
+    close(listener);
+    unlink(path);
+
+    return served;
+
+}   /* runServer() */
+
+#endif /* SERVER_H */
+
+/*** end of file ***/
@@ -0,0 +1,532 @@
+/**
+ * @file     simulate.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Monte Carlo simulation of the stock of a reference with a
+ *           random daily demand, under (Q, R) policies: every day the
+ *           demand is served (or backordered), and whenever the stock
+ *           position (on hand - backorders + on order) is at R or
+ *           below, Q units are ordered, which arrive after the lead time.
+ *
+ *           The demand of a day is normal (mean and standard deviation,
+ *           rounded and cut at 0) or drawn from an empirical sample of
+ *           daily demands. The random numbers come from Philox4x32-10,
+ *           a counter-based generator: the numbers of a day depend only
+ *           on the seed, the chunk of years and the day, so the results
+ *           do not depend on the threads or on the order of the work.
+ *           Both laws are drawn from an alias table, one random word per
+ *           day (see buildDemandTable()).
+ *
+ *           The years are simulated in chunks of SIMULATION_CHUNK_YEARS
+ *           consecutive years (after a warm-up year that is not counted),
+ *           spread over the threads with parallelFor(). Every policy sees
+ *           the same demands (common random numbers), so the differences
+ *           between policies are not noise of the demand, and each day is
+ *           drawn once for all of them. The sums of each chunk are added
+ *           in chunk order at the end, so the figures are the same with
+ *           any number of threads.
+ */
+
+#ifndef SIMULATE_H
+#define SIMULATE_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "eoq.h"
+#include "threadpool.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+//-----[ CONSTANTS ]----------------------------------------------------------//
+
+// Days of a simulated year
+#define SIMULATION_DAYS 365
+
+// Consecutive years of each chunk (the work unit of a thread)
+#define SIMULATION_CHUNK_YEARS 64
+
+// Longest lead time, in days
+#define SIMULATION_MAX_LEAD 3650
+
+// Largest alias table of a normal demand (see buildDemandTable())
+#define SIMULATION_MAX_TABLE (1 << 20)
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef struct
+{
+    double mean;                    // Mean daily demand (normal)
+    double stddev;                  // Standard deviation of it (normal)
+    const vector<int> * sample;     // Daily demands to draw from, or NULL
+
+} demand_model_t;
+
+typedef struct
+{
+    uint64_t threshold;     // Coins below it (· 2^32) take value
+    int value;              // Daily demand of the slot
+    int other;              // Daily demand of its alias, taken otherwise
+
+} demand_slot_t;
+
+typedef struct
+{
+    vector<demand_slot_t> slots;
+
+} demand_table_t;
+
+typedef struct
+{
+    int Q;          // Units of each order
+    int R;          // Reorder point (stock position that triggers it)
+
+} policy_t;
+
+typedef struct
+{
+    double years;
+    double orders;          // Orders placed
+    double cycles;          // Orders received
+    double stockouts;       // Cycles with some demand not served on time
+    double demand;          // Units demanded
+    double backordered;     // Units not served on the day of their demand
+    double CA;              // Sums of the annual costs
+    double CE;
+    double CP;
+    double CT;
+    double CT2;             // Sum of the squares of the annual CT
+
+} policy_stats_t;
+
+typedef struct
+{
+    int64_t net;            // On hand - backorders
+    int64_t on_order;
+    bool short_cycle;       // Some demand backordered since the last arrival
+
+} policy_state_t;
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that computes one block of Philox4x32-10 (Salmon et
+ *         al., "Parallel random numbers: as easy as 1, 2, 3", SC 2011):
+ *         ten rounds of multiplications and xors of the counter, with a
+ *         Weyl sequence of the key.
+ * @param  counter  Counter of the block (4 words).
+ * @param  key  Key of the stream (2 words).
+ * @param  out  Where the 4 random words are stored.
+ * @return void
+ */
+inline void philox4x32(const uint32_t counter[4], const uint32_t key[2],
+                       uint32_t out[4])
+{
+    uint32_t c0 = counter[0], c1 = counter[1];
+    uint32_t c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+
+    for (int round = 0; round < 10; round++)
+    {
+        uint64_t p0 = (uint64_t)0xD2511F53u * c0;
+        uint64_t p1 = (uint64_t)0xCD9E8D57u * c2;
+
+        uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+
+        c0 = n0;
+        c1 = (uint32_t)p1;
+        c2 = n2;
+        c3 = (uint32_t)p0;
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+
+}   /* philox4x32() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that builds the alias table (Vose's method) of the
+ *         daily demand. The demand of a day is a whole number of units,
+ *         so a normal one is the discrete law of round(mean + stddev·z)
+ *         cut at 0, over mean ± 8.5 standard deviations (the rest of the
+ *         mass goes to both ends); a sample gives each value the same
+ *         weight. A day is then drawn with one random word and no log()
+ *         nor cos().
+ * @param  model  Demand model.
+ * @param  table  Where the table is stored.
+ * @return false if the normal law needs more than SIMULATION_MAX_TABLE
+ *         values (drawDemands() then uses Box-Muller).
+ */
+inline bool buildDemandTable(const demand_model_t * model,
+                             demand_table_t * table)
+{
+    vector<double> weight;
+    vector<int> values;
+
+    if (model->sample != NULL)
+    {
+        values = *(model->sample);
+        weight.assign(values.size(), 1.0);
+    }
+    else if (model->stddev == 0.0)
+    {
+        values.push_back((int)lround(model->mean));
+        weight.push_back(1.0);
+    }
+    else
+    {
+        double spread = 8.5 * model->stddev;
+        double low = max(0.0, floor(model->mean - spread));
+        double high = max(0.0, ceil(model->mean + spread));
+
+        if (high - low + 1 > SIMULATION_MAX_TABLE)
+        {
+            return false;
+        }
+
+        auto cdf = [&](double x)
+        {
+            return 0.5 * erfc((model->mean - x) /
+                              (model->stddev * 1.4142135623730951));
+        };
+
+        for (double k = low; k <= high; k++)
+        {
+            double below = (k == low) ? 0.0 : cdf(k - 0.5);
+            double above = (k == high) ? 1.0 : cdf(k + 0.5);
+
+            values.push_back((int)k);
+            weight.push_back(max(0.0, above - below));
+        }
+    }
+
+    // Vose: every slot keeps its own value up to its threshold and the
+    // value of a heavier slot above it
+    size_t n = weight.size();
+    double total = 0.0;
+    vector<size_t> small, large;
+
+    for (double w : weight)
+    {
+        total += w;
+    }
+
+    table->slots.resize(n);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        table->slots[i] = { (uint64_t)1 << 32, values[i], values[i] };
+        weight[i] *= n / total;
+        ((weight[i] < 1.0) ? small : large).push_back(i);
+    }
+
+    while (!small.empty() && !large.empty())
+    {
+        size_t s = small.back(), l = large.back();
+
+        small.pop_back();
+        table->slots[s].threshold = (uint64_t)(weight[s] * 4294967296.0);
+        table->slots[s].other = values[l];
+        weight[l] -= 1.0 - weight[s];
+
+        if (weight[l] < 1.0)
+        {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    return true;
+
+}   /* buildDemandTable() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that turns a random word into a uniform number in
+ *         (0, 1], so that its logarithm is always finite.
+ * @param  word  Random word.
+ * @return Uniform number.
+ */
+inline double uniformOf(uint32_t word)
+{
+    return (word + 1.0) * (1.0 / 4294967296.0);
+
+}   /* uniformOf() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that draws the demands of some consecutive days of a
+ *         chunk. Each Philox block gives four days: with a table, the
+ *         high part of word · n picks a slot and the low part is the
+ *         coin between its value and its alias; without one, four
+ *         normal values (two Box-Muller pairs).
+ * @param  model  Demand model.
+ * @param  table  Alias table of the demand (buildDemandTable()), or NULL.
+ * @param  key  Key of the simulation (from the seed).
+ * @param  chunk  Number of the chunk.
+ * @param  first  First day of the chunk to draw (a multiple of 4).
+ * @param  days  Number of days to draw (a multiple of 4).
+ * @param  demand  Where the demands are stored.
+ * @return void
+ */
+inline void drawDemands(const demand_model_t * model,
+                        const demand_table_t * table, const uint32_t key[2],
+                        uint32_t chunk, uint32_t first, int days, int * demand)
+{
+    const double two_pi = 6.283185307179586;
+    const demand_slot_t * slots = (table != NULL) ?
+                                  table->slots.data() : NULL;
+    uint64_t n = (table != NULL) ? table->slots.size() : 0;
+
+    for (int d = 0; d < days; d += 4)
+    {
+        uint32_t counter[4] = { (first + d) / 4, chunk, 0, 0 };
+        uint32_t word[4];
+
+        philox4x32(counter, key, word);
+
+        if (table != NULL)
+        {
+            for (int k = 0; k < 4; k++)
+            {
+                uint64_t spin = word[k] * n;
+                const demand_slot_t & slot = slots[spin >> 32];
+
+                demand[d + k] = ((uint32_t)spin < slot.threshold) ?
+                                slot.value : slot.other;
+            }
+            continue;
+        }
+
+        for (int k = 0; k < 4; k += 2)
+        {
+            double r = sqrt(-2.0 * log(uniformOf(word[k])));
+            double angle = two_pi * uniformOf(word[k + 1]);
+            double z[2] = { r * cos(angle), r * sin(angle) };
+
+            for (int h = 0; h < 2; h++)
+            {
+                double x = model->mean + model->stddev * z[h];
+
+                demand[d + k + h] = (x > 0.0) ? (int)lround(x) : 0;
+            }
+        }
+    }
+
+}   /* drawDemands() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that simulates one chunk of consecutive years for every
+ *         policy, after a warm-up year.
+ * @param  tiers  Tiers of the reference.
+ * @param  model  Demand model.
+ * @param  table  Alias table of the demand, or NULL.
+ * @param  lead  Lead time, in days.
+ * @param  policies  Policies to simulate.
+ * @param  key  Key of the simulation (from the seed).
+ * @param  chunk  Number of the chunk.
+ * @param  years  Years to count in this chunk.
+ * @param  stats  Where the sums of each policy are added.
+ * @return void
+ */
+inline void simulateChunk(const tiers_t * tiers, const demand_model_t * model,
+                          const demand_table_t * table, int lead,
+                          const vector<policy_t> & policies,
+                          const uint32_t key[2], uint32_t chunk, int years,
+                          policy_stats_t * stats)
+{
+    size_t count = policies.size();
+    int slots = lead + 1;
+    vector<policy_state_t> state(count);
+    vector<int64_t> pipeline(count * slots, 0);
+    vector<float> ca(count), ce(count), cp(count);
+    int demand[SIMULATION_DAYS + 3];
+    uint32_t day = 0;
+
+    for (size_t p = 0; p < count; p++)
+    {
+        tierPrices(tiers, policies[p].Q, &ca[p], &ce[p]);
+        cp[p] = tiers->cp_percentage * ca[p];
+        state[p] = { (int64_t)policies[p].R + policies[p].Q, 0, false };
+    }
+
+    for (int year = -1; year < years; year++)
+    {
+        // Days of the year, drawn in blocks of 4 from the day counter
+        int skip = day % 4;
+        int first = day % slots;
+
+        drawDemands(model, table, key, chunk, day - skip,
+                    (skip + SIMULATION_DAYS + 3) / 4 * 4, demand);
+
+        for (size_t p = 0; p < count; p++)
+        {
+            int64_t * arrivals = &pipeline[p * slots];
+            int64_t Q = policies[p].Q;
+            int64_t R = policies[p].R;
+            int64_t net = state[p].net;
+            int64_t on_order = state[p].on_order;
+            bool short_cycle = state[p].short_cycle;
+            int64_t orders = 0, cycles = 0, stockouts = 0;
+            int64_t units = 0, backordered = 0, on_hand = 0;
+            int slot = first;
+
+            for (int d = 0; d < SIMULATION_DAYS; d++)
+            {
+                // An order placed today arrives in the slot of yesterday
+                int due = (slot == 0) ? lead : (slot - 1);
+                int64_t today = demand[skip + d];
+
+                if (arrivals[slot] > 0)
+                {
+                    net += arrivals[slot];
+                    on_order -= arrivals[slot];
+                    arrivals[slot] = 0;
+                    cycles++;
+                    stockouts += short_cycle;
+                    short_cycle = false;
+                }
+
+                // Units of today's demand that cannot be served
+                int64_t missing = (net >= today) ? 0 :
+                                  (net > 0) ? (today - net) : today;
+
+                net -= today;
+                units += today;
+                backordered += missing;
+                short_cycle = short_cycle || (missing > 0);
+
+                while (net + on_order <= R)
+                {
+                    orders++;
+
+                    if (lead == 0)
+                    {
+                        // It arrives at once and closes the cycle
+                        net += Q;
+                        cycles++;
+                        stockouts += short_cycle;
+                        short_cycle = false;
+                        continue;
+                    }
+
+                    arrivals[due] += Q;
+                    on_order += Q;
+                }
+
+                on_hand += (net > 0) ? net : 0;
+                slot = (slot == lead) ? 0 : (slot + 1);
+            }
+
+            state[p] = { net, on_order, short_cycle };
+
+            if (year < 0)
+            {
+                continue;
+            }
+
+            policy_stats_t & sum = stats[p];
+            double CA = ca[p] * (double)Q * orders;
+            double CE = ce[p] * (double)orders;
+            double CP = cp[p] * (double)on_hand / SIMULATION_DAYS;
+            double CT = CA + CE + CP;
+
+            sum.years++;
+            sum.orders += orders;
+            sum.cycles += cycles;
+            sum.stockouts += stockouts;
+            sum.demand += units;
+            sum.backordered += backordered;
+            sum.CA += CA;
+            sum.CE += CE;
+            sum.CP += CP;
+            sum.CT += CT;
+            sum.CT2 += CT * CT;
+        }
+
+        day += SIMULATION_DAYS;
+    }
+
+}   /* simulateChunk() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that simulates some years of every policy.
+ * @param  tiers  Tiers of the reference.
+ * @param  model  Demand model.
+ * @param  lead  Lead time, in days (0 to SIMULATION_MAX_LEAD).
+ * @param  policies  Policies to simulate (Q > 0).
+ * @param  years  Years to simulate (rounded up to whole chunks).
+ * @param  seed  Seed of the random numbers.
+ * @param  threads  Number of threads.
+ * @param  stats  Where the sums of each policy are stored.
+ * @return void
+ */
+inline void simulatePolicies(const tiers_t * tiers,
+                             const demand_model_t * model, int lead,
+                             const vector<policy_t> & policies, long years,
+                             uint64_t seed, int threads,
+                             vector<policy_stats_t> * stats)
+{
+    size_t chunks = (years + SIMULATION_CHUNK_YEARS - 1) /
+                    SIMULATION_CHUNK_YEARS;
+    size_t count = policies.size();
+    vector<policy_stats_t> partial(chunks * count);
+    const uint32_t key[2] = { (uint32_t)seed, (uint32_t)(seed >> 32) };
+    demand_table_t table;
+    bool tabled = buildDemandTable(model, &table);
+
+    auto simulate = [&](size_t begin, size_t end)
+    {
+        for (size_t c = begin; c < end; c++)
+        {
+            simulateChunk(tiers, model, tabled ? &table : NULL, lead,
+                          policies, key, (uint32_t)c,
+                          SIMULATION_CHUNK_YEARS, &partial[c * count]);
+        }
+    };
+
+    parallelFor(chunks, threads, 1, simulate);
+
+    // Add the chunks in order, so the sums do not depend on the threads
+    stats->assign(count, policy_stats_t());
+
+    for (size_t c = 0; c < chunks; c++)
+    {
+        for (size_t p = 0; p < count; p++)
+        {
+            const policy_stats_t & part = partial[c * count + p];
+            policy_stats_t & sum = (*stats)[p];
+
+            sum.years += part.years;
+            sum.orders += part.orders;
+            sum.cycles += part.cycles;
+            sum.stockouts += part.stockouts;
+            sum.demand += part.demand;
+            sum.backordered += part.backordered;
+            sum.CA += part.CA;
+            sum.CE += part.CE;
+            sum.CP += part.CP;
+            sum.CT += part.CT;
+            sum.CT2 += part.CT2;
+        }
+    }
+
+}   /* simulatePolicies() */
+
+#endif /* SIMULATE_H */
+
+/*** end of file ***/
@@ -0,0 +1,557 @@
+/**
+ * @file     snapshot.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Binary snapshot of a catalog, compiled once from the text
+ *           catalog and mapped read-only with mmap() at startup. The
+ *           mapped file is used as is: lookups and solves read the
+ *           tiers straight from it, with no parsing and no allocation.
+ *
+ *           Layout of the file (version 2, native byte order, every
+ *           section aligned to 8 bytes):
+ *
+ *             snapshot_header_t   Magic, version and section offsets.
+ *             snapshot_record_t   One per reference, in catalog order.
+ *             uint32_t            Record numbers sorted by ID (index).
+ *             cost_t              Pool with the tiers of every reference.
+ *             char                String table, each string ends in '\0'.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "types.h"
+#include "catalog.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+//-----[ CONSTANTS ]----------------------------------------------------------//
+
+#define SNAPSHOT_MAGIC   "EOQSNAP"
+#define SNAPSHOT_VERSION 2
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef struct
+{
+    char magic[8];              // SNAPSHOT_MAGIC
+    uint32_t version;           // SNAPSHOT_VERSION
+    uint32_t count;             // Number of references
+    uint64_t stamp;             // catalogStamp() of the compiled catalog
+    uint64_t records_offset;
+    uint64_t index_offset;
+    uint64_t pool_offset;
+    uint64_t pool_count;        // Number of cost_t in the pool
+    uint64_t strings_offset;
+    uint64_t strings_size;
+    uint64_t file_size;
+
+} snapshot_header_t;
+
+typedef struct
+{
+    uint32_t id_offset;         // Into the string table
+    uint32_t id_length;
+    uint32_t description_offset;
+    uint32_t description_length;
+    uint32_t ca_offset;         // Into the pool
+    uint32_t ca_count;
+    uint32_t ce_offset;
+    uint32_t ce_count;
+    float cp_percentage;
+    uint32_t reserved;
+
+} snapshot_record_t;
+
+typedef struct
+{
+    void * base;                // Mapped file (NULL if not open)
+    size_t size;
+    const snapshot_header_t * header;
+    const snapshot_record_t * records;
+    const uint32_t * index;
+    const cost_t * pool;
+    const char * strings;
+
+} snapshot_t;
+
+static_assert(sizeof(cost_t) == 8, "cost_t is stored as is in the pool");
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that rounds a size of the file up to 8 bytes.
+ * @param  size  Size to round.
+ * @return Rounded size.
+ */
+inline uint64_t snapshotAlign(uint64_t size)
+{
+    return (size + 7) & ~(uint64_t)7;
+
+}   /* snapshotAlign() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that writes the snapshot of a catalog to a file. Every
+ *         reference must use the original cost model (see policy.h).
+ * @param  catalog  Catalog to compile.
+ * @param  path  Path of the snapshot file.
+ * @param  error  Where the reason is stored if it cannot be written.
+ * @return true if the snapshot was written.
+ */
+inline bool compileSnapshot(const catalog_t * catalog, const char * path,
+                            string * error)
+{
+    const vector<reference_t> & references = catalog->references;
+    vector<snapshot_record_t> records(references.size());
+    vector<uint32_t> index(references.size());
+    vector<cost_t> pool;
+    string strings;
+
+    for (size_t i = 0; i < references.size(); i++)
+    {
+        const reference_t & item = references[i];
+        snapshot_record_t & record = records[i];
+
+        // The records only have room for the original cost model
+        if (originalModel(&(item.model)) == false)
+        {
+            *error = "'" + item.id + "' no usa el modelo de costes original";
+            return false;
+        }
+
+        memset(&record, 0, sizeof(record));
+
+        record.id_offset = (uint32_t)strings.size();
+        record.id_length = (uint32_t)item.id.size();
+        strings.append(item.id).push_back('\0');
+
+        record.description_offset = (uint32_t)strings.size();
+        record.description_length = (uint32_t)item.description.size();
+        strings.append(item.description).push_back('\0');
+
+        record.ca_offset = (uint32_t)pool.size();
+        record.ca_count = (uint32_t)item.ca_list.size();
+        pool.insert(pool.end(), item.ca_list.begin(), item.ca_list.end());
+
+        record.ce_offset = (uint32_t)pool.size();
+        record.ce_count = (uint32_t)item.ce_list.size();
+        pool.insert(pool.end(), item.ce_list.begin(), item.ce_list.end());
+
+        record.cp_percentage = item.cp_percentage;
+        index[i] = (uint32_t)i;
+    }
+
+    // Index sorted by ID, for the binary search of findSnapshotReference()
+    sort(index.begin(), index.end(), [&](uint32_t a, uint32_t b)
+    {
+        return references[a].id < references[b].id;
+    });
+
+    snapshot_header_t header;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.count = (uint32_t)references.size();
+    header.stamp = catalogStamp(catalog);
+    header.records_offset = snapshotAlign(sizeof(header));
+    header.index_offset = snapshotAlign(header.records_offset +
+                                        records.size() * sizeof(records[0]));
+    header.pool_offset = snapshotAlign(header.index_offset +
+                                       index.size() * sizeof(index[0]));
+    header.pool_count = pool.size();
+    header.strings_offset = snapshotAlign(header.pool_offset +
+                                          pool.size() * sizeof(cost_t));
+    header.strings_size = strings.size();
+    header.file_size = header.strings_offset + strings.size();
+
+    FILE * file = fopen(path, "wb");
+
+    if (file == NULL)
+    {
+        *error = string("no se puede crear el fichero '") + path + "'";
+        return false;
+    }
+
+    // Write every section at its offset, padding with zeros in between
+    const char zeros[8] = { 0 };
+    uint64_t written = 0;
+    bool ok = true;
+
+    struct { uint64_t offset; const void * data; size_t size; } sections[] =
+    {
+        { 0, &header, sizeof(header) },
+        { header.records_offset, records.data(),
+          records.size() * sizeof(snapshot_record_t) },
+        { header.index_offset, index.data(), index.size() * sizeof(uint32_t) },
+        { header.pool_offset, pool.data(), pool.size() * sizeof(cost_t) },
+        { header.strings_offset, strings.data(), strings.size() }
+    };
+
+    for (size_t s = 0; s < sizeof(sections) / sizeof(sections[0]); s++)
+    {
+        ok = ok && (fwrite(zeros, 1, sections[s].offset - written, file) ==
+                    sections[s].offset - written);
+        ok = ok && (fwrite(sections[s].data, 1, sections[s].size, file) ==
+                    sections[s].size);
+        written = sections[s].offset + sections[s].size;
+    }
+
+    ok = (fclose(file) == 0) && ok;
+
+    if (ok == false)
+    {
+        *error = string("error al escribir el fichero '") + path + "'";
+    }
+
+    return ok;
+
+}   /* compileSnapshot() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that checks that a section of count items of a given
+ *         size starts aligned inside the file and ends inside it.
+ * @param  offset  Offset of the section.
+ * @param  count  Number of items.
+ * @param  item  Size of each item.
+ * @param  size  Size of the file.
+ * @return true if the section fits in the file.
+ */
+inline bool snapshotSectionFits(uint64_t offset, uint64_t count, size_t item,
+                                uint64_t size)
+{
+    return (offset % 8 == 0) && (offset <= size) &&
+           (count <= (size - offset) / item);
+
+}   /* snapshotSectionFits() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that checks that a string of the table is inside it and
+ *         ends in '\0' where its length says.
+ * @param  snapshot  Open snapshot.
+ * @param  offset  Offset of the string in the table.
+ * @param  length  Length of the string.
+ * @return true if the string can be read.
+ */
+inline bool snapshotStringFits(const snapshot_t * snapshot, uint32_t offset,
+                               uint32_t length)
+{
+    uint64_t end = (uint64_t)offset + length;
+
+    return (end < snapshot->header->strings_size) &&
+           (snapshot->strings[end] == '\0');
+
+}   /* snapshotStringFits() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that checks that a list of tiers of a record is inside
+ *         the pool and can be solved: not empty, starting at 1 unit,
+ *         sorted by units and with finite, non negative prices.
+ * @param  snapshot  Open snapshot.
+ * @param  offset  Offset of the list in the pool.
+ * @param  count  Number of tiers.
+ * @return true if the tiers can be used.
+ */
+inline bool snapshotTiersFit(const snapshot_t * snapshot, uint32_t offset,
+                             uint32_t count)
+{
+    if ((count == 0) || (count > INT_MAX) ||
+        ((uint64_t)offset + count > snapshot->header->pool_count))
+    {
+        return false;
+    }
+
+    const cost_t * list = snapshot->pool + offset;
+
+    if (list[0].min_unit != 1)
+    {
+        return false;
+    }
+
+    for (uint32_t j = 0; j < count; j++)
+    {
+        if (((j > 0) && (list[j].min_unit <= list[j - 1].min_unit)) ||
+            !isfinite(list[j].value) || (list[j].value < 0))
+        {
+            return false;
+        }
+    }
+
+    return true;
+
+}   /* snapshotTiersFit() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that checks a record of a snapshot against the mapped
+ *         file before it is used, so that no solve reads out of it (see
+ *         snapshotTiersFit() and snapshotStringFits()).
+ * @param  snapshot  Open snapshot.
+ * @param  i  Record number of the reference.
+ * @return true if the record is valid.
+ */
+inline bool validSnapshotRecord(const snapshot_t * snapshot, size_t i)
+{
+    if (i >= snapshot->header->count)
+    {
+        return false;
+    }
+
+    const snapshot_record_t & record = snapshot->records[i];
+
+    return snapshotStringFits(snapshot, record.id_offset, record.id_length) &&
+           snapshotStringFits(snapshot, record.description_offset,
+                              record.description_length) &&
+           snapshotTiersFit(snapshot, record.ca_offset, record.ca_count) &&
+           snapshotTiersFit(snapshot, record.ce_offset, record.ce_count) &&
+           isfinite(record.cp_percentage) && (record.cp_percentage >= 0);
+
+}   /* validSnapshotRecord() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that maps a snapshot file read-only. Only the header
+ *         is checked (magic, version and that every section fits in the
+ *         file), so the startup does not grow with the catalog: each
+ *         record is checked when a lookup reaches it.
+ * @param  path  Path of the snapshot file.
+ * @param  snapshot  Where the view of the file is stored.
+ * @param  error  Where the reason is stored if it cannot be opened.
+ * @return true if the snapshot is open.
+ */
+inline bool openSnapshot(const char * path, snapshot_t * snapshot,
+                         string * error)
+{
+    memset(snapshot, 0, sizeof(*snapshot));
+
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+    {
+        *error = string("no se puede abrir el fichero '") + path + "'";
+        return false;
+    }
+
+    struct stat info;
+
+    if ((fstat(fd, &info) != 0) ||
+        ((size_t)info.st_size < sizeof(snapshot_header_t)))
+    {
+        close(fd);
+        *error = string("'") + path + "' no es un snapshot de catálogo";
+        return false;
+    }
+
+    void * base = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED)
+    {
+        *error = string("no se puede mapear el fichero '") + path + "'";
+        return false;
+    }
+
+    const snapshot_header_t * header = (const snapshot_header_t *)base;
+    uint64_t size = info.st_size;
+
+    if ((memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) ||
+        (header->version != SNAPSHOT_VERSION) ||
+        (header->file_size != size) ||
+        !snapshotSectionFits(header->records_offset, header->count,
+                             sizeof(snapshot_record_t), size) ||
+        !snapshotSectionFits(header->index_offset, header->count,
+                             sizeof(uint32_t), size) ||
+        !snapshotSectionFits(header->pool_offset, header->pool_count,
+                             sizeof(cost_t), size) ||
+        (header->strings_offset > size) ||
+        (header->strings_size > size - header->strings_offset))
+    {
+        munmap(base, size);
+        *error = string("'") + path + "' no es un snapshot de catálogo " +
+                 "(versión " + to_string(SNAPSHOT_VERSION) + ")";
+        return false;
+    }
+
+    snapshot->base = base;
+    snapshot->size = size;
+    snapshot->header = header;
+    snapshot->records = (const snapshot_record_t *)
+                        ((const char *)base + header->records_offset);
+    snapshot->index = (const uint32_t *)
+                      ((const char *)base + header->index_offset);
+    snapshot->pool = (const cost_t *)
+                     ((const char *)base + header->pool_offset);
+    snapshot->strings = (const char *)base + header->strings_offset;
+
+    return true;
+
+}   /* openSnapshot() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that unmaps a snapshot opened with openSnapshot().
+ * @param  snapshot  Snapshot to close.
+ * @return void
+ */
+inline void closeSnapshot(snapshot_t * snapshot)
+{
+    if (snapshot->base != NULL)
+    {
+        munmap(snapshot->base, snapshot->size);
+    }
+
+    memset(snapshot, 0, sizeof(*snapshot));
+
+}   /* closeSnapshot() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that finds a reference of the snapshot by its ID with
+ *         a binary search over the sorted index. Every entry it visits
+ *         is checked, and so is the record it finds (see
+ *         validSnapshotRecord()): a damaged one is never returned.
+ * @param  snapshot  Open snapshot.
+ * @param  id  ID of the reference.
+ * @param  length  Length of the ID.
+ * @return Record number of the reference, or -1 if it is not there or
+ *         its record is not valid.
+ */
+inline long findSnapshotReference(const snapshot_t * snapshot,
+                                  const char * id, size_t length)
+{
+    size_t lo = 0;
+    size_t hi = snapshot->header->count;
+
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        uint32_t i = snapshot->index[mid];
+
+        if ((i >= snapshot->header->count) ||
+            !snapshotStringFits(snapshot, snapshot->records[i].id_offset,
+                                snapshot->records[i].id_length))
+        {
+            return -1;
+        }
+
+        const snapshot_record_t & record = snapshot->records[i];
+        size_t common = min((size_t)record.id_length, length);
+        int order = memcmp(snapshot->strings + record.id_offset, id, common);
+
+        if (order == 0)
+        {
+            if (record.id_length == length)
+            {
+                return validSnapshotRecord(snapshot, i) ? (long)i : -1;
+            }
+
+            order = (record.id_length < length) ? -1 : 1;
+        }
+
+        if (order < 0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return -1;
+
+}   /* findSnapshotReference() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that gets the tiers of a reference of the snapshot,
+ *         pointing straight into the mapped pool.
+ * @param  snapshot  Open snapshot.
+ * @param  i  Record number of the reference (from findSnapshotReference(),
+ *            so it is valid).
+ * @return View of the tiers (valid while the snapshot is open).
+ */
+inline tiers_t snapshotTiers(const snapshot_t * snapshot, size_t i)
+{
+    const snapshot_record_t & record = snapshot->records[i];
+    tiers_t tiers;
+
+    tiers.ca_list = snapshot->pool + record.ca_offset;
+    tiers.ca_count = (int)record.ca_count;
+    tiers.ce_list = snapshot->pool + record.ce_offset;
+    tiers.ce_count = (int)record.ce_count;
+    tiers.cp_percentage = record.cp_percentage;
+    tiers.model = NULL;
+
+    return tiers;
+
+}   /* snapshotTiers() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that gets the ID of a reference of the snapshot.
+ * @param  snapshot  Open snapshot.
+ * @param  i  Record number of the reference.
+ * @return ID ended in '\0', inside the mapped string table ("" if its
+ *         record is damaged).
+ */
+inline const char * snapshotId(const snapshot_t * snapshot, size_t i)
+{
+    const snapshot_record_t & record = snapshot->records[i];
+
+    if (!snapshotStringFits(snapshot, record.id_offset, record.id_length))
+    {
+        return "";
+    }
+
+    return snapshot->strings + record.id_offset;
+
+}   /* snapshotId() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that gets the description of a reference of the snapshot.
+ * @param  snapshot  Open snapshot.
+ * @param  i  Record number of the reference.
+ * @return Description ended in '\0', inside the mapped string table
+ *         ("" if its record is damaged).
+ */
+inline const char * snapshotDescription(const snapshot_t * snapshot, size_t i)
+{
+    const snapshot_record_t & record = snapshot->records[i];
+
+    if (!snapshotStringFits(snapshot, record.description_offset,
+                            record.description_length))
+    {
+        return "";
+    }
+
+    return snapshot->strings + record.description_offset;
+
+}   /* snapshotDescription() */
+
+#endif /* SNAPSHOT_H */
+
+/*** end of file ***/
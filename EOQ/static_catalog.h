@@ -0,0 +1,592 @@
+/**
+ * @file     static_catalog.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Catalog of references declared as constexpr data, for builds
+ *           that ship a fixed catalog (g++ -DEOQ_STATIC_CATALOG, see
+ *           catalog_static.h). The tiers live in fixed-size arrays, so
+ *           the solver reads them in place and startup allocates nothing.
+ *
+ *           The IDs are indexed with a perfect hash (hash and
+ *           displace): each ID falls in a bucket by a first hash, and
+ *           every bucket gets the smallest seed of a second hash that
+ *           sends all its IDs to free slots of the table. A lookup is
+ *           then one hash of the ID, one slot and one comparison, with
+ *           no probing and no table built at runtime. The seeds and the
+ *           slots are searched when the catalog is exported and written
+ *           as constexpr arrays; the compiler only checks them, one hash
+ *           per ID (see checkStaticIndex() and the static_assert of the
+ *           header written by exportStaticCatalog()). Searching them in
+ *           constexpr code ran out of the operations that GCC allows
+ *           with a few hundred references.
+ */
+
+#ifndef STATIC_CATALOG_H
+#define STATIC_CATALOG_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "types.h"
+#include "catalog.h"
+
+#include <algorithm>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//-----[ CONSTANTS ]----------------------------------------------------------//
+
+// Room for the tiers of each list (the exported header sets its own)
+#ifndef STATIC_MAX_TIERS
+#define STATIC_MAX_TIERS 16
+#endif
+
+// Average IDs per bucket of the first hash
+#define STATIC_BUCKET_KEYS 4
+
+// Slots of the table per ID
+#define STATIC_LOAD 2
+
+// Seeds tried for a bucket before the catalog is given up
+#define STATIC_MAX_SEED (1u << 20)
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef struct
+{
+    const char * id;
+    const char * description;
+    float cp_percentage;
+    int ca_count;
+    cost_t ca_list[STATIC_MAX_TIERS];   // Acquisition Cost tiers
+    int ce_count;
+    cost_t ce_list[STATIC_MAX_TIERS];   // Cost of Issue tiers
+
+} static_reference_t;
+
+template <size_t N>
+struct static_index_t
+{
+    uint32_t seed[N / STATIC_BUCKET_KEYS + 1];      // Seed of each bucket
+    int slot[N * STATIC_LOAD];                      // Reference, or -1
+
+};
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that hashes an ID (64-bit FNV-1a). It is the only pass
+ *         over the characters: the bucket and the slot are taken from it.
+ *         The last characters of FNV-1a only reach a few bits, so IDs
+ *         that differ at the end (REF1, REF2...) would share a bucket;
+ *         the finalizer of MurmurHash3 spreads them over all the bits.
+ * @param  id  Characters of the ID.
+ * @param  length  Number of characters.
+ * @return Hash of the ID.
+ */
+constexpr uint64_t staticHash(const char * id, size_t length)
+{
+    uint64_t h = 0xCBF29CE484222325ull;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        h = (h ^ (unsigned char)id[i]) * 0x100000001B3ull;
+    }
+
+    h = (h ^ (h >> 33)) * 0xFF51AFD7ED558CCDull;
+    h = (h ^ (h >> 33)) * 0xC4CEB9FE1A85EC53ull;
+
+    return h ^ (h >> 33);
+
+}   /* staticHash() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that maps the hash of an ID to a bucket, with a
+ *         multiplication instead of a division.
+ * @param  h  Hash of the ID (from staticHash()).
+ * @param  buckets  Number of buckets.
+ * @return Bucket of the ID.
+ */
+constexpr size_t staticBucket(uint64_t h, size_t buckets)
+{
+    return (size_t)(((h & 0xFFFFFFFFull) * buckets) >> 32);
+
+}   /* staticBucket() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that maps the hash of an ID to a slot of the table with
+ *         the seed of its bucket (the seed is mixed in with the finalizer
+ *         of MurmurHash3, so every seed gives an unrelated slot).
+ * @param  h  Hash of the ID (from staticHash()).
+ * @param  seed  Seed of the bucket of the ID.
+ * @param  slots  Number of slots.
+ * @return Slot of the ID.
+ */
+constexpr size_t staticSlot(uint64_t h, uint32_t seed, size_t slots)
+{
+    h ^= seed * 0x9E3779B97F4A7C15ull;
+    h = (h ^ (h >> 33)) * 0xFF51AFD7ED558CCDull;
+    h = (h ^ (h >> 33)) * 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+
+    return (size_t)(((h >> 32) * slots) >> 32);
+
+}   /* staticSlot() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that counts the characters of a string at compile time.
+ * @param  text  String ended in '\0'.
+ * @return Number of characters.
+ */
+constexpr size_t staticLength(const char * text)
+{
+    size_t length = 0;
+
+    while (text[length] != '\0')
+    {
+        length++;
+    }
+
+    return length;
+
+}   /* staticLength() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that builds the perfect hash of the IDs of a catalog,
+ *         when it is exported. The buckets are placed from the largest
+ *         to the smallest, each with the first seed that sends its IDs
+ *         to distinct free slots. Every seed tried only looks at the IDs
+ *         of its bucket, so a catalog of thousands of references takes
+ *         a few milliseconds.
+ * @param  references  Catalog of references (not empty).
+ * @param  seed  Where the seed of each bucket is stored.
+ * @param  slot  Where the reference of each slot (or -1) is stored.
+ * @return true if every ID was placed (false for a repeated ID).
+ */
+inline bool buildStaticIndex(const vector<reference_t> & references,
+                             vector<uint32_t> * seed, vector<int> * slot)
+{
+    const size_t N = references.size();
+    const size_t buckets = N / STATIC_BUCKET_KEYS + 1;
+    const size_t slots = N * STATIC_LOAD;
+
+    vector<uint64_t> hash(N);
+    vector<vector<size_t>> members(buckets);
+    vector<size_t> order(buckets);
+    vector<size_t> placed;
+
+    seed->assign(buckets, 0);
+    slot->assign(slots, -1);
+
+    for (size_t r = 0; r < N; r++)
+    {
+        const string & id = references[r].id;
+
+        hash[r] = staticHash(id.data(), id.size());
+        members[staticBucket(hash[r], buckets)].push_back(r);
+    }
+
+    // Largest buckets first, while the table is still empty
+    for (size_t b = 0; b < buckets; b++)
+    {
+        order[b] = b;
+    }
+
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+    {
+        return members[a].size() > members[b].size();
+    });
+
+    for (size_t k = 0; (k < buckets) && !members[order[k]].empty(); k++)
+    {
+        const vector<size_t> & bucket = members[order[k]];
+        bool found = false;
+
+        for (uint32_t s = 1; (s < STATIC_MAX_SEED) && !found; s++)
+        {
+            placed.clear();
+            found = true;
+
+            for (size_t m = 0; (m < bucket.size()) && found; m++)
+            {
+                size_t at = staticSlot(hash[bucket[m]], s, slots);
+
+                found = ((*slot)[at] < 0) &&
+                        (find(placed.begin(), placed.end(), at) ==
+                         placed.end());
+                placed.push_back(at);
+            }
+
+            if (found)
+            {
+                (*seed)[order[k]] = s;
+
+                for (size_t m = 0; m < bucket.size(); m++)
+                {
+                    (*slot)[placed[m]] = (int)bucket[m];
+                }
+            }
+        }
+
+        if (found == false)
+        {
+            return false;
+        }
+    }
+
+    return true;
+
+}   /* buildStaticIndex() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that checks at compile time that the index written by
+ *         exportStaticCatalog() is the one of the references: each ID,
+ *         hashed with the seed of its bucket, must land on the slot of
+ *         its own reference. It is one hash per ID, so it stays far
+ *         from the limits of constexpr evaluation for any catalog, and
+ *         it fails if the data were edited without exporting again.
+ * @param  references  Catalog of references.
+ * @param  index  Perfect hash of its IDs.
+ * @return true if every reference is found through the index.
+ */
+template <size_t N>
+constexpr bool checkStaticIndex(const static_reference_t (&references)[N],
+                                const static_index_t<N> & index)
+{
+    const size_t buckets = N / STATIC_BUCKET_KEYS + 1;
+    const size_t slots = N * STATIC_LOAD;
+
+    for (size_t r = 0; r < N; r++)
+    {
+        const char * id = references[r].id;
+        uint64_t h = staticHash(id, staticLength(id));
+        uint32_t seed = index.seed[staticBucket(h, buckets)];
+
+        if (index.slot[staticSlot(h, seed, slots)] != (int)r)
+        {
+            return false;
+        }
+    }
+
+    return true;
+
+}   /* checkStaticIndex() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that finds a reference of a constexpr catalog by its
+ *         ID, in constant time.
+ * @param  references  Catalog of references.
+ * @param  index  Perfect hash of its IDs (from buildStaticIndex()).
+ * @param  id  Characters of the ID.
+ * @param  length  Number of characters.
+ * @return Pointer to the reference, or NULL if it is not in the catalog.
+ */
+template <size_t N>
+inline const static_reference_t * findStaticReference(
+                                    const static_reference_t (&references)[N],
+                                    const static_index_t<N> & index,
+                                    const char * id, size_t length)
+{
+    uint64_t h = staticHash(id, length);
+    uint32_t seed = index.seed[staticBucket(h, N / STATIC_BUCKET_KEYS + 1)];
+    int r = index.slot[staticSlot(h, seed, N * STATIC_LOAD)];
+
+    if ((r < 0) || (strncmp(references[r].id, id, length) != 0) ||
+        (references[r].id[length] != '\0'))
+    {
+        return NULL;
+    }
+
+    return &(references[r]);
+
+}   /* findStaticReference() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that gets the tiers of a constexpr reference as a view
+ *         for the solver.
+ * @param  item  Pointer to reference.
+ * @return View of the tiers (valid for the whole program).
+ */
+inline tiers_t staticTiers(const static_reference_t * item)
+{
+    tiers_t tiers;
+
+    tiers.ca_list = item->ca_list;
+    tiers.ca_count = item->ca_count;
+    tiers.ce_list = item->ce_list;
+    tiers.ce_count = item->ce_count;
+    tiers.cp_percentage = item->cp_percentage;
+    tiers.model = NULL;
+
+    return tiers;
+
+}   /* staticTiers() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that computes the stamp of a constexpr catalog, equal
+ *         to the catalogStamp() of the same references loaded as text.
+ * @param  references  Catalog of references.
+ * @return Stamp of the catalog.
+ */
+template <size_t N>
+inline uint64_t staticCatalogStamp(const static_reference_t (&references)[N])
+{
+    uint64_t h = 0xCBF29CE484222325ull;
+
+    for (size_t i = 0; i < N; i++)
+    {
+        const static_reference_t & item = references[i];
+        size_t counts[2] = { (size_t)item.ca_count, (size_t)item.ce_count };
+
+        h = hashBytes(h, item.id, strlen(item.id) + 1);
+        h = hashBytes(h, counts, sizeof(counts));
+        h = hashBytes(h, item.ca_list, item.ca_count * sizeof(cost_t));
+        h = hashBytes(h, item.ce_list, item.ce_count * sizeof(cost_t));
+        h = hashBytes(h, &(item.cp_percentage), sizeof(item.cp_percentage));
+    }
+
+    return h;
+
+}   /* staticCatalogStamp() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that writes a string as a C++ literal.
+ * @param  file  File being written.
+ * @param  text  String to write.
+ * @return void
+ */
+inline void writeStaticString(FILE * file, const string & text)
+{
+    fputc('"', file);
+
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        if ((text[i] == '"') || (text[i] == '\\'))
+        {
+            fputc('\\', file);
+        }
+
+        fputc(text[i], file);
+    }
+
+    fputc('"', file);
+
+}   /* writeStaticString() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that writes a float as the shortest C++ literal that
+ *         reads back as the same float.
+ * @param  file  File being written.
+ * @param  value  Value to write.
+ * @return void
+ */
+inline void writeStaticFloat(FILE * file, float value)
+{
+    char text[32];
+
+    for (int digits = 6; digits <= 9; digits++)
+    {
+        snprintf(text, sizeof(text), "%.*g", digits, value);
+
+        if (strtof(text, NULL) == value)
+        {
+            break;
+        }
+    }
+
+    fputs(text, file);
+
+    if (strpbrk(text, ".e") == NULL)
+    {
+        fputs(".0", file);
+    }
+
+    fputc('f', file);
+
+}   /* writeStaticFloat() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that writes a list of tiers as a constexpr array, a
+ *         few tiers per line.
+ * @param  file  File being written.
+ * @param  list  Tiers to write.
+ * @return void
+ */
+inline void writeStaticTiers(FILE * file, const vector<cost_t> & list)
+{
+    fprintf(file, "      %2d, {", (int)list.size());
+
+    for (size_t t = 0; t < list.size(); t++)
+    {
+        if (t > 0)
+        {
+            fputs((t % 3 == 0) ? ",\n           " : ",", file);
+        }
+
+        fprintf(file, " { %d, ", list[t].min_unit);
+        writeStaticFloat(file, list[t].value);
+        fputs(" }", file);
+    }
+
+    fputs(" }", file);
+
+}   /* writeStaticTiers() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that writes a list of numbers as the body of a constexpr
+ *         array, twelve per line.
+ * @param  file  File being written.
+ * @param  values  Numbers to write.
+ * @return void
+ */
+template <typename T>
+inline void writeStaticNumbers(FILE * file, const vector<T> & values)
+{
+    fputs("    {", file);
+
+    for (size_t v = 0; v < values.size(); v++)
+    {
+        if (v > 0)
+        {
+            fputs((v % 12 == 0) ? ",\n     " : ",", file);
+        }
+
+        fprintf(file, " %lld", (long long)values[v]);
+    }
+
+    fputs(" }", file);
+
+}   /* writeStaticNumbers() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that writes a catalog as a header of constexpr data
+ *         (STATIC_REFERENCES, STATIC_COUNT and STATIC_INDEX), to build
+ *         the program with -DEOQ_STATIC_CATALOG. Every reference must
+ *         use the original cost model (see policy.h).
+ * @param  catalog  Catalog of references (not empty).
+ * @param  path  Path of the header to write.
+ * @param  error  Where the reason is stored if it cannot be written.
+ * @return true if the header was written.
+ */
+inline bool exportStaticCatalog(const catalog_t * catalog, const char * path,
+                                string * error)
+{
+    const vector<reference_t> & references = catalog->references;
+    size_t tiers = 1;
+
+    if (references.empty())
+    {
+        *error = "el catálogo está vacío";
+        return false;
+    }
+
+    for (const reference_t & item : references)
+    {
+        tiers = max(tiers, max(item.ca_list.size(), item.ce_list.size()));
+
+        // The constexpr references only have the original cost model
+        if (originalModel(&(item.model)) == false)
+        {
+            *error = "'" + item.id + "' no usa el modelo de costes original";
+            return false;
+        }
+    }
+
+    vector<uint32_t> seed;
+    vector<int> slot;
+
+    if (buildStaticIndex(references, &seed, &slot) == false)
+    {
+        *error = "los IDs no tienen hash perfecto (¿hay un ID repetido?)";
+        return false;
+    }
+
+    FILE * file = fopen(path, "w");
+
+    if (file == NULL)
+    {
+        *error = string("no se puede crear el fichero '") + path + "'";
+        return false;
+    }
+
+    fputs("/**\n"
+          " * @file     catalog_static.h\n"
+          " *\n"
+          " * @section  LIO-GIIROB\n"
+          " * @brief    Catalog of references as constexpr data, written"
+          " by\n"
+          " *           optimalQ --export-static (see static_catalog.h)."
+          " Build\n"
+          " *           with g++ -DEOQ_STATIC_CATALOG to use it.\n"
+          " */\n\n"
+          "#ifndef CATALOG_STATIC_H\n"
+          "#define CATALOG_STATIC_H\n\n", file);
+    fprintf(file, "#define STATIC_MAX_TIERS %d\n\n", (int)tiers);
+    fputs("#include \"static_catalog.h\"\n\n"
+          "constexpr static_reference_t STATIC_REFERENCES[] =\n{\n", file);
+
+    for (size_t i = 0; i < references.size(); i++)
+    {
+        const reference_t & item = references[i];
+
+        fputs("    { ", file);
+        writeStaticString(file, item.id);
+        fputs(", ", file);
+        writeStaticString(file, item.description);
+        fputs(", ", file);
+        writeStaticFloat(file, item.cp_percentage);
+        fputs(",\n", file);
+        writeStaticTiers(file, item.ca_list);
+        fputs(",\n", file);
+        writeStaticTiers(file, item.ce_list);
+        fprintf(file, " }%s\n", (i + 1 < references.size()) ? "," : "");
+    }
+
+    fputs("};\n\n"
+          "constexpr size_t STATIC_COUNT =\n"
+          "    sizeof(STATIC_REFERENCES) / sizeof(STATIC_REFERENCES[0]);\n\n"
+          "constexpr static_index_t<STATIC_COUNT> STATIC_INDEX =\n{\n",
+          file);
+    writeStaticNumbers(file, seed);
+    fputs(",\n", file);
+    writeStaticNumbers(file, slot);
+    fputs("\n};\n\n"
+          "static_assert(checkStaticIndex(STATIC_REFERENCES, STATIC_INDEX),\n"
+          "              \"STATIC_INDEX is not the index of the IDs\");\n"
+          "\n#endif /* CATALOG_STATIC_H */\n\n"
+          "/*** end of file ***/\n", file);
+
+    if (fclose(file) != 0)
+    {
+        *error = string("error al escribir el fichero '") + path + "'";
+        return false;
+    }
+
+    return true;
+
+}   /* exportStaticCatalog() */
+
+#endif /* STATIC_CATALOG_H */
+
+/*** end of file ***/
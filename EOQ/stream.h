@@ -0,0 +1,423 @@
+/**
+ * @file     stream.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Rolling annual demand of many references fed by a stream of
+ *           daily consumptions, with their Q* kept up to date.
+ *
+ *           Every reference keeps the units of the last 365 days in a
+ *           ring (one slot per day, all the rings in one block) and
+ *           their sum, the Annual Demand D. The clock of the stream is
+ *           the latest day seen: when it moves, the days that leave the
+ *           window are taken out of every reference.
+ *
+ *           Re-solving is incremental: each solve also keeps the piece
+ *           of its optimum (see pieceAround() of sweep.h), the range of
+ *           demands with the same Q and tiers, found from the change
+ *           points of its segment and the breakpoints next to it. While
+ *           D stays inside that range the Q* is known without solving,
+ *           which is the case of almost every event. The Q* reported is
+ *           the one of solveOptimalQ(), as in the batch mode: inside the
+ *           piece it is found by pieceOptimalQ(), which only evaluates
+ *           the window of Q next to the exact optimum.
+ */
+
+#ifndef STREAM_H
+#define STREAM_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "sweep.h"
+
+#include <climits>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+//-----[ CONSTANTS ]----------------------------------------------------------//
+
+// Days of the rolling window
+#define STREAM_WINDOW_DAYS 365
+
+// Largest Annual Demand that can be solved (Q goes up to twice this)
+#define STREAM_MAX_DEMAND (INT_MAX / 2)
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef struct
+{
+    tiers_t tiers;
+    size_t ring;            // First slot of its ring in stream_t::units
+    int64_t D;              // Units of the window
+    sweep_piece_t piece;    // Piece of the exact optimum (Q = 0: none)
+    solution_t best;        // Q* of D, as solveOptimalQ() (Q = 0: no order)
+
+} stream_item_t;
+
+typedef struct
+{
+    vector<stream_item_t> items;
+    vector<string> ids;                     // ID of every item
+    unordered_map<string, size_t> index;    // ID -> position in items
+    vector<int64_t> units;                  // Rings of every item
+    int64_t today;                          // Latest day seen
+    bool started;                           // false until the first event
+    uint64_t events;
+    uint64_t late;                          // Events before the window
+    uint64_t solves;                        // Calls to pieceAround()
+
+} stream_t;
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that prepares an empty stream.
+ * @param  stream  Stream of demands.
+ * @return void
+ */
+inline void initStream(stream_t * stream)
+{
+    stream->items.clear();
+    stream->ids.clear();
+    stream->index.clear();
+    stream->units.clear();
+    stream->today = 0;
+    stream->started = false;
+    stream->events = 0;
+    stream->late = 0;
+    stream->solves = 0;
+
+}   /* initStream() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that gets the slot of a day in the ring of an item.
+ * @param  day  Days since 1970-01-01.
+ * @return Slot of the day, from 0 to STREAM_WINDOW_DAYS - 1.
+ */
+inline size_t streamSlot(int64_t day)
+{
+    int64_t slot = day % STREAM_WINDOW_DAYS;
+
+    return (size_t)((slot < 0) ? (slot + STREAM_WINDOW_DAYS) : slot);
+
+}   /* streamSlot() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that counts the days from 1970-01-01 to a date of the
+ *         proleptic Gregorian calendar.
+ * @param  y  Year.
+ * @param  m  Month (1 to 12).
+ * @param  d  Day (1 to 31).
+ * @return Days since 1970-01-01 (negative before it).
+ */
+inline int64_t daysFromCivil(int64_t y, int m, int d)
+{
+    y -= (m <= 2);
+
+    int64_t era = ((y >= 0) ? y : (y - 399)) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (m + ((m > 2) ? -3 : 9)) + 2) / 5 + d - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * 146097 + doe - 719468;
+
+}   /* daysFromCivil() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that counts the days of a month of the proleptic
+ *         Gregorian calendar.
+ * @param  y  Year.
+ * @param  m  Month (1 to 12).
+ * @return Days of the month (29 for February of a leap year).
+ */
+inline int daysInMonth(int64_t y, int m)
+{
+    const int days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    bool leap = ((y % 4 == 0) && (y % 100 != 0)) || (y % 400 == 0);
+
+    return ((m == 2) && leap) ? 29 : days[m - 1];
+
+}   /* daysInMonth() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that writes a day of the stream as YYYY-MM-DD.
+ * @param  day  Days since 1970-01-01.
+ * @param  text  Where the date is written (at least 32 characters).
+ * @param  size  Size of text.
+ * @return void
+ */
+inline void civilDate(int64_t day, char * text, size_t size)
+{
+    day += 719468;
+
+    int64_t era = ((day >= 0) ? day : (day - 146096)) / 146097;
+    int64_t doe = day - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    int d = (int)(doy - (153 * mp + 2) / 5 + 1);
+    int m = (int)((mp < 10) ? (mp + 3) : (mp - 9));
+    int64_t y = yoe + era * 400 + (m <= 2);
+
+    snprintf(text, size, "%04lld-%02d-%02d", (long long)y, m, d);
+
+}   /* civilDate() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that reads the day of an event: a date YYYY-MM-DD (the
+ *         time after it, if any, is ignored) or a Unix timestamp in
+ *         seconds.
+ * @param  begin  First character of the timestamp.
+ * @param  end  One past its last character.
+ * @param  day  Where the days since 1970-01-01 are stored.
+ * @return false if it is neither a valid date nor a timestamp.
+ */
+inline bool parseStreamDay(const char * begin, const char * end,
+                           int64_t * day)
+{
+    size_t length = end - begin;
+
+    if ((length >= 10) && (begin[4] == '-') && (begin[7] == '-'))
+    {
+        int field[3] = { 0, 0, 0 };
+        const int digits[3][2] = { { 0, 4 }, { 5, 2 }, { 8, 2 } };
+
+        for (int f = 0; f < 3; f++)
+        {
+            for (int c = 0; c < digits[f][1]; c++)
+            {
+                char digit = begin[digits[f][0] + c];
+
+                if ((digit < '0') || (digit > '9'))
+                {
+                    return false;
+                }
+
+                field[f] = field[f] * 10 + (digit - '0');
+            }
+        }
+
+        if ((field[1] < 1) || (field[1] > 12) || (field[2] < 1) ||
+            (field[2] > daysInMonth(field[0], field[1])))
+        {
+            return false;
+        }
+
+        *day = daysFromCivil(field[0], field[1], field[2]);
+        return true;
+    }
+
+    int64_t seconds = 0;
+
+    if (length == 0)
+    {
+        return false;
+    }
+
+    for (const char * c = begin; c < end; c++)
+    {
+        if ((*c < '0') || (*c > '9') || (seconds > INT64_MAX / 10 - 9))
+        {
+            return false;
+        }
+
+        seconds = seconds * 10 + (*c - '0');
+    }
+
+    *day = seconds / 86400;
+
+    return true;
+
+}   /* parseStreamDay() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that finds the item of a reference by its ID.
+ * @param  stream  Stream of demands.
+ * @param  id  ID of the reference.
+ * @return Position of the item, or -1 if the reference has no events yet.
+ */
+inline long findStreamItem(const stream_t * stream, const string & id)
+{
+    unordered_map<string, size_t>::const_iterator searched;
+    searched = stream->index.find(id);
+
+    if (searched == stream->index.end())
+    {
+        return -1;
+    }
+
+    return (long)searched->second;
+
+}   /* findStreamItem() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that adds the item of a reference, with an empty window.
+ * @param  stream  Stream of demands.
+ * @param  id  ID of the reference (not in the stream yet).
+ * @param  tiers  Tiers of the reference.
+ * @return Position of the item.
+ */
+inline size_t addStreamItem(stream_t * stream, const string & id,
+                            const tiers_t * tiers)
+{
+    stream_item_t item;
+
+    item.tiers = *tiers;
+    item.ring = stream->units.size();
+    item.D = 0;
+    item.piece = { 0, 0, 0, 0, 0 };
+    item.best = { 0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+
+    stream->index[id] = stream->items.size();
+    stream->items.push_back(item);
+    stream->ids.push_back(id);
+    stream->units.resize(stream->units.size() + STREAM_WINDOW_DAYS, 0);
+
+    return stream->items.size() - 1;
+
+}   /* addStreamItem() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that updates the Q* of an item after a change of its
+ *         demand. It only looks for the piece of the exact optimum if D
+ *         has left it.
+ * @param  stream  Stream of demands.
+ * @param  item  Item whose D has changed.
+ * @return true if its Q* has changed.
+ */
+inline bool updateStreamItem(stream_t * stream, stream_item_t * item)
+{
+    sweep_piece_t & piece = item->piece;
+    int old_Q = item->best.Q;
+
+    if ((item->D <= 0) || (item->D > STREAM_MAX_DEMAND))
+    {
+        // Nothing to order (or beyond the solver): no piece
+        piece = { 0, 0, 0, 0, 0 };
+        item->best = { 0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+        return (old_Q != 0);
+    }
+
+    if ((piece.Q == 0) || (item->D < piece.D_from) || (item->D > piece.D_to))
+    {
+        pieceAround(&(item->tiers), (int)item->D, 1, STREAM_MAX_DEMAND,
+                    &piece);
+        stream->solves++;
+    }
+
+    item->best = pieceOptimalQ(&(item->tiers), &piece, (int)item->D);
+
+    return (item->best.Q != old_Q);
+
+}   /* updateStreamItem() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that moves the clock of the stream to a later day. The
+ *         days that leave the window are taken out of every item, and
+ *         each item whose Q* changes is reported.
+ * @param  stream  Stream of demands.
+ * @param  day  New day (later than stream->today).
+ * @param  changed  Called with the position of every item that changed.
+ * @return void
+ */
+template <typename F>
+inline void advanceStream(stream_t * stream, int64_t day, F changed)
+{
+    int64_t from = stream->today + 1;
+    int64_t to = day;
+
+    // Past a whole window every slot is emptied once
+    if (to - from >= STREAM_WINDOW_DAYS)
+    {
+        from = to - STREAM_WINDOW_DAYS + 1;
+    }
+
+    stream->today = day;
+
+    for (size_t i = 0; i < stream->items.size(); i++)
+    {
+        stream_item_t & item = stream->items[i];
+        int64_t * ring = &(stream->units[item.ring]);
+        int64_t D = item.D;
+
+        for (int64_t d = from; d <= to; d++)
+        {
+            int64_t & slot = ring[streamSlot(d)];
+
+            item.D -= slot;
+            slot = 0;
+        }
+
+        if ((item.D != D) && updateStreamItem(stream, &item))
+        {
+            changed(i);
+        }
+    }
+
+}   /* advanceStream() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that adds an event to the stream: the units that a
+ *         reference consumed on a day.
+ * @param  stream  Stream of demands.
+ * @param  i  Position of the item (see findStreamItem()).
+ * @param  day  Day of the consumption (days since 1970-01-01).
+ * @param  units  Units consumed (negative for returns).
+ * @param  changed  Called with the position of every item that changed.
+ * @return void
+ */
+template <typename F>
+inline void addStreamEvent(stream_t * stream, size_t i, int64_t day,
+                           int64_t units, F changed)
+{
+    stream->events++;
+
+    if (stream->started == false)
+    {
+        stream->started = true;
+        stream->today = day;
+    }
+    else if (day > stream->today)
+    {
+        advanceStream(stream, day, changed);
+    }
+
+    if (day <= stream->today - STREAM_WINDOW_DAYS)
+    {
+        stream->late++;
+        return;
+    }
+
+    stream_item_t & item = stream->items[i];
+
+    stream->units[item.ring + streamSlot(day)] += units;
+    item.D += units;
+
+    if (updateStreamItem(stream, &item))
+    {
+        changed(i);
+    }
+
+}   /* addStreamEvent() */
+
+#endif /* STREAM_H */
+
+/*** end of file ***/
@@ -0,0 +1,335 @@
+/**
+ * @file     suppliers.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    References that can be bought from more than one supplier:
+ *           the tiers of the catalog are one offer, and the offers file
+ *           adds others, each with its own tiers and a shipping cost per
+ *           order. The file has one offer per line with five fields
+ *           separated by ';', in the tier format of catalog.h:
+ *
+ *             id;supplier;ca_list;ce_list;shipping
+ *
+ *             110212;Tapas Levante;1:0.17 500:0.11;1:4.5;12
+ *
+ *           The best supplier of a reference is chosen by branch and
+ *           bound. Every offer gets a lower bound that only needs its
+ *           cheapest prices: whatever Q is, its CT is at least
+ *
+ *             ca_min·D + sqrt(2·D·ce_min·cp_percentage·ca_min)
+ *
+ *           the EOQ cost with the cheapest ca and ce of the offer. The
+ *           offers are solved in increasing bound, and the first one
+ *           whose bound cannot beat the best CT so far ends the search:
+ *           the rest of the offers are never solved.
+ */
+
+#ifndef SUPPLIERS_H
+#define SUPPLIERS_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "types.h"
+#include "catalog.h"
+#include "eoq.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef struct
+{
+    int offer;              // Offer of reference_t::offers, -1 for the catalog
+    solution_t solution;    // Q* and costs with that offer
+    int solved;             // Offers that had to be solved
+
+} supplier_choice_t;
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that gets the tiers of an offer as a view for the solver,
+ *         with the cost of ownership of its reference.
+ * @param  item  Reference of the offer.
+ * @param  offer  Offer of the reference, or -1 for the catalog tiers.
+ * @return View of the tiers (valid while the reference is alive).
+ */
+inline tiers_t offerTiers(const reference_t * item, int offer)
+{
+    if (offer < 0)
+    {
+        return tiersOf(item);
+    }
+
+    const offer_t & o = item->offers[offer];
+    tiers_t tiers;
+
+    tiers.ca_list = o.ca_list.data();
+    tiers.ca_count = (int)o.ca_list.size();
+    tiers.ce_list = o.ce_list.data();
+    tiers.ce_count = (int)o.ce_list.size();
+    tiers.cp_percentage = item->cp_percentage;
+    tiers.model = &(item->model);
+
+    return tiers;
+
+}   /* offerTiers() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that computes a lower bound of the CT of every Q with
+ *         some tiers (see the top of the file).
+ * @param  D  Annual Demand.
+ * @param  tiers  Tiers of the offer.
+ * @return Lower bound of the CT.
+ */
+inline double offerLowerBound(int D, const tiers_t * tiers)
+{
+    float ca = (tiers->ca_list[0]).value;
+    float ce = (tiers->ce_list[0]).value;
+
+    for (int t = 1; t < tiers->ca_count; t++)
+    {
+        ca = min(ca, (tiers->ca_list[t]).value);
+    }
+
+    for (int t = 1; t < tiers->ce_count; t++)
+    {
+        ce = min(ce, (tiers->ce_list[t]).value);
+    }
+
+    return ca * (double)D +
+           sqrt(2.0 * D * (double)ce * tiers->cp_percentage * ca);
+
+}   /* offerLowerBound() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that picks the offer with the lowest CT at its Q* (the
+ *         catalog tiers on a tie, then the first offer) by branch and
+ *         bound (see the top of the file).
+ * @param  D  Annual Demand (positive).
+ * @param  item  Reference with its offers.
+ * @param  choice  Where the offer, its solution and the work are stored.
+ * @return void
+ */
+inline void solveSuppliers(int D, const reference_t * item,
+                           supplier_choice_t * choice)
+{
+    int count = (int)item->offers.size() + 1;
+    vector<double> bound(count);
+    vector<int> order(count);
+
+    for (int k = 0; k < count; k++)
+    {
+        tiers_t tiers = offerTiers(item, k - 1);
+
+        bound[k] = offerLowerBound(D, &tiers);
+        order[k] = k;
+    }
+
+    // Offers by increasing bound (stable, so ties keep the file order)
+    for (int k = 1; k < count; k++)
+    {
+        int offer = order[k];
+        int m = k;
+
+        while ((m > 0) && (bound[order[m - 1]] > bound[offer]))
+        {
+            order[m] = order[m - 1];
+            m--;
+        }
+
+        order[m] = offer;
+    }
+
+    choice->offer = -1;
+    choice->solved = 0;
+
+    for (int k = 0; k < count; k++)
+    {
+        int offer = order[k];
+
+        // The float CT of a solve may be a few ulps below the exact one
+        if ((choice->solved > 0) &&
+            (bound[offer] > choice->solution.CT * (1.0 + CT_TOLERANCE)))
+        {
+            break;
+        }
+
+        tiers_t tiers = offerTiers(item, offer - 1);
+        solution_t s = solveOptimalQ(D, &tiers);
+
+        choice->solved++;
+
+        if ((choice->solved == 1) || (s.CT < choice->solution.CT) ||
+            ((s.CT == choice->solution.CT) && (offer - 1 < choice->offer)))
+        {
+            choice->offer = offer - 1;
+            choice->solution = s;
+        }
+    }
+
+}   /* solveSuppliers() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that parses one line of an offers file.
+ * @param  begin  First character of the line.
+ * @param  end  One past the last character of the line.
+ * @param  id  Where the ID of the reference is stored.
+ * @param  offer  Where the offer is stored (ce_list without the shipping).
+ * @return false if the line does not have the five expected fields.
+ */
+inline bool parseOfferLine(const char * begin, const char * end, string * id,
+                           offer_t * offer)
+{
+    const char * field[5];
+    int fields = 1;
+
+    field[0] = begin;
+
+    for (const char * p = begin; p < end; p++)
+    {
+        if (*p == ';')
+        {
+            if (fields == 5)
+            {
+                return false;
+            }
+
+            field[fields++] = p + 1;
+        }
+    }
+
+    if (fields != 5)
+    {
+        return false;
+    }
+
+    id->assign(field[0], field[1] - 1);
+    offer->supplier.assign(field[1], field[2] - 1);
+
+    if ((parseTiers(field[2], field[3] - 1, &(offer->ca_list)) == false) ||
+        (parseTiers(field[3], field[4] - 1, &(offer->ce_list)) == false))
+    {
+        return false;
+    }
+
+    char * next;
+    offer->shipping = strtof(field[4], &next);
+
+    while ((next < end) && (*next == ' '))
+    {
+        next++;
+    }
+
+    return (next != field[4]) && (next == end);
+
+}   /* parseOfferLine() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that loads an offers file (see the format at the top of
+ *         this file) into the references of a catalog.
+ * @param  path  Path of the offers file.
+ * @param  catalog  Catalog whose references receive the offers.
+ * @param  error  Where the reason is stored if the file is not valid.
+ * @return true if every offer of the file was loaded.
+ */
+inline bool loadOffers(const char * path, catalog_t * catalog, string * error)
+{
+    FILE * file = fopen(path, "rb");
+
+    if (file == NULL)
+    {
+        *error = string("no se puede abrir el fichero '") + path + "'";
+        return false;
+    }
+
+    string text;
+    char block[1 << 16];
+    size_t n;
+
+    while ((n = fread(block, 1, sizeof(block), file)) > 0)
+    {
+        text.append(block, n);
+    }
+
+    fclose(file);
+
+    const char * p = text.c_str();
+    const char * stop = p + text.size();
+    int lineNumber = 0;
+
+    while (p < stop)
+    {
+        const char * end = (const char *)memchr(p, '\n', stop - p);
+
+        if (end == NULL)
+        {
+            end = stop;
+        }
+
+        const char * next = end + 1;
+        lineNumber++;
+
+        if ((end > p) && (end[-1] == '\r'))
+        {
+            end--;
+        }
+
+        if ((end > p) && (*p != '#'))
+        {
+            string id;
+            offer_t offer;
+            long i;
+
+            if (parseOfferLine(p, end, &id, &offer) == false)
+            {
+                *error = "línea " + to_string(lineNumber) + ": se esperaba " +
+                         "'id;proveedor;ca_list;ce_list;envío'";
+                return false;
+            }
+
+            if (((i = findReferencePosition(catalog, id)) < 0) ||
+                (validateTiers(offer.ca_list, "ca_list", error) == false) ||
+                (validateTiers(offer.ce_list, "ce_list", error) == false) ||
+                (offer.shipping < 0))
+            {
+                *error = "línea " + to_string(lineNumber) + ": " +
+                         ((i < 0) ? ("la referencia '" + id +
+                                     "' no está en el catálogo") :
+                          (offer.shipping < 0) ? string("envío negativo") :
+                                                 *error);
+                return false;
+            }
+
+            // The shipping is paid once per order, as the cost of issue
+            for (cost_t & tier : offer.ce_list)
+            {
+                tier.value += offer.shipping;
+            }
+
+            catalog->references[i].offers.push_back(offer);
+        }
+
+        p = next;
+    }
+
+    return true;
+
+}   /* loadOffers() */
+
+#endif /* SUPPLIERS_H */
+
+/*** end of file ***/
@@ -0,0 +1,401 @@
+/**
+ * @file     sweep.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Sweep of the Q* of a reference over a range of Annual Demands.
+ *
+ *           Inside a segment with fixed tiers, CT = ca·D + ce·D/Q + cp·Q/2
+ *           and Q is better than Q + 1 while D <= cp·Q·(Q + 1) / (2·ce).
+ *           So Q*(D) is a step function: it stays on the same Q (and
+ *           tiers) over whole intervals of D, where CT(D) is a straight
+ *           line. The sweep jumps from one change point to the next
+ *           with that closed form, and only bisects when another
+ *           segment takes over, so its cost grows with the number of
+ *           pieces and breakpoints instead of with the size of the range.
+ *
+ *           Those pieces are the ones of the exact cost (modelOptimum()).
+ *           solveOptimalQ() keeps the first minimum of the float CT
+ *           instead, which near the optimum may be another Q of a small
+ *           window (see windowOptimalQ()). So each demand of an exact
+ *           piece is solved with that window, starting from the exact
+ *           minimum that the piece already gives, and the exact pieces
+ *           are split where the float Q* changes: every demand of a
+ *           piece returned by sweepOptimalQ() has the Q* and the costs
+ *           of the batch mode. This second step costs O(tiers + W) per
+ *           demand, W being a handful of Q below some thousands of
+ *           units of demand (see solveOptimalQ()).
+ */
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "eoq.h"
+
+#include <math.h>
+#include <vector>
+
+using namespace std;
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef struct
+{
+    int D_from;     // First demand of the piece
+    int D_to;       // Last demand of the piece
+    int Q;          // Q* of every demand of the piece (see below)
+    int i;          // Tier of ca_list
+    int j;          // Tier of ce_list
+
+} sweep_piece_t;
+
+// The pieces of pieceAround() keep the optimum of the exact cost, those
+// of sweepOptimalQ() the one of solveOptimalQ()
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that checks if a demand has the same optimum (Q and
+ *         tiers) as a piece.
+ * @param  D  Annual demand for the reference.
+ * @param  tiers  Tiers of the reference.
+ * @param  piece  Piece to compare with.
+ * @return true if D belongs to the piece.
+ */
+inline bool samePiece(int D, const tiers_t * tiers,
+                      const sweep_piece_t * piece)
+{
+    segment_t seg = { 0, 0, 0, 0 };
+    int Q = 0;
+
+    modelOptimum(D, tiers, &seg, &Q);
+
+    return (Q == piece->Q) && (seg.i == piece->i) && (seg.j == piece->j);
+
+}   /* samePiece() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that predicts the last demand that keeps the best Q of
+ *         a segment, that is, the last D with CT(Q) <= CT(Q + 1). If Q
+ *         is already the last unit of the segment, or CT does not depend
+ *         on D that way, there is no prediction and D_max is returned.
+ * @param  tiers  Tiers of the reference.
+ * @param  seg  Segment of the optimum.
+ * @param  Q  Best Q of the segment.
+ * @param  D  Current demand.
+ * @param  D_max  Last demand of the sweep.
+ * @return Predicted last demand of the piece, between D and D_max.
+ */
+inline int predictPieceEnd(const tiers_t * tiers, const segment_t * seg,
+                           int Q, int D, int D_max)
+{
+    float ca = (tiers->ca_list[seg->i]).value;
+    float ce = (tiers->ce_list[seg->j]).value;
+    float cp = tiers->cp_percentage * ca;
+
+    if ((Q >= seg->hi) || (ce <= 0) || (cp <= 0))
+    {
+        return D_max;
+    }
+
+    double end = floor(cp * (double)Q * (Q + 1.0) / (2.0 * ce));
+
+    if (end >= D_max)
+    {
+        return D_max;
+    }
+
+    return (end > D) ? (int)end : D;
+
+}   /* predictPieceEnd() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that predicts the first demand that keeps the best Q of
+ *         a segment, that is, the first D with CT(Q) < CT(Q - 1). If Q is
+ *         the first unit of the segment there is no prediction and D_min
+ *         is returned.
+ * @param  tiers  Tiers of the reference.
+ * @param  seg  Segment of the optimum.
+ * @param  Q  Best Q of the segment.
+ * @param  D  Current demand.
+ * @param  D_min  First demand that is considered.
+ * @return Predicted first demand of the piece, between D_min and D.
+ */
+inline int predictPieceStart(const tiers_t * tiers, const segment_t * seg,
+                             int Q, int D, int D_min)
+{
+    float ca = (tiers->ca_list[seg->i]).value;
+    float ce = (tiers->ce_list[seg->j]).value;
+    float cp = tiers->cp_percentage * ca;
+
+    if ((Q <= seg->lo) || (ce <= 0) || (cp <= 0))
+    {
+        return D_min;
+    }
+
+    double start = floor(cp * (Q - 1.0) * (double)Q / (2.0 * ce)) + 1.0;
+
+    if (start <= D_min)
+    {
+        return D_min;
+    }
+
+    return (start < D) ? (int)start : D;
+
+}   /* predictPieceStart() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that finds the piece that contains a demand, that is,
+ *         its optimum and the range of demands around it that keep the
+ *         same one. Each end is predicted from the segment of the
+ *         optimum and checked; if another segment wins first, the end
+ *         is found by bisection. A piece found this way may fall short
+ *         of the true one (never past it), so a demand outside of it
+ *         only means that the optimum has to be found again.
+ * @param  tiers  Tiers of the reference.
+ * @param  D  Annual demand for the reference.
+ * @param  D_min  First demand that is considered (at least 1).
+ * @param  D_max  Last demand that is considered (at most INT_MAX / 2).
+ * @param  piece  Where the piece is stored.
+ * @return void
+ */
+inline void pieceAround(const tiers_t * tiers, int D, int D_min, int D_max,
+                        sweep_piece_t * piece)
+{
+    segment_t seg = { 0, 0, 0, 0 };
+
+    modelOptimum(D, tiers, &seg, &(piece->Q));
+    piece->i = seg.i;
+    piece->j = seg.j;
+
+    int inside = D;
+    int outside = predictPieceEnd(tiers, &seg, piece->Q, D, D_max);
+
+    if (samePiece(outside, tiers, piece))
+    {
+        inside = outside;
+    }
+
+    // Bisect between the last demand known inside and the first outside
+    while (outside - inside > 1)
+    {
+        int middle = inside + (outside - inside) / 2;
+
+        if (samePiece(middle, tiers, piece))
+        {
+            inside = middle;
+        }
+        else
+        {
+            outside = middle;
+        }
+    }
+
+    piece->D_to = inside;
+
+    inside = D;
+    outside = predictPieceStart(tiers, &seg, piece->Q, D, D_min);
+
+    if (samePiece(outside, tiers, piece))
+    {
+        inside = outside;
+    }
+
+    while (inside - outside > 1)
+    {
+        int middle = outside + (inside - outside) / 2;
+
+        if (samePiece(middle, tiers, piece))
+        {
+            inside = middle;
+        }
+        else
+        {
+            outside = middle;
+        }
+    }
+
+    piece->D_from = inside;
+
+}   /* pieceAround() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that splits [D_min, D_max] into the pieces where the
+ *         exact optimum of a reference (its Q and tiers) does not
+ *         change. Each piece starts at the predicted change point of
+ *         its Q; if another segment wins before that, the end is found
+ *         by bisection.
+ * @param  tiers  Tiers of the reference.
+ * @param  D_min  First demand (at least 1).
+ * @param  D_max  Last demand (at most INT_MAX / 2).
+ * @param  pieces  Where the pieces are appended, in increasing D.
+ * @return void
+ */
+inline void sweepModelQ(const tiers_t * tiers, int D_min, int D_max,
+                        vector<sweep_piece_t> * pieces)
+{
+    if ((D_min <= 0) || (D_min > D_max) ||
+        (tiers->ca_count == 0) || (tiers->ce_count == 0))
+    {
+        return;
+    }
+
+    int D = D_min;
+
+    for (;;)
+    {
+        segment_t seg = { 0, 0, 0, 0 };
+        sweep_piece_t piece;
+
+        modelOptimum(D, tiers, &seg, &(piece.Q));
+        piece.D_from = D;
+        piece.i = seg.i;
+        piece.j = seg.j;
+
+        int last = D;
+        int end = predictPieceEnd(tiers, &seg, piece.Q, D, D_max);
+
+        if (samePiece(end, tiers, &piece))
+        {
+            last = end;
+        }
+        else
+        {
+            // Another segment wins first: last is in the piece, end is not
+            while (end - last > 1)
+            {
+                int middle = last + (end - last) / 2;
+
+                if (samePiece(middle, tiers, &piece))
+                {
+                    last = middle;
+                }
+                else
+                {
+                    end = middle;
+                }
+            }
+        }
+
+        piece.D_to = last;
+
+        // A prediction that falls short only splits a piece: join it
+        if ((pieces->empty() == false) &&
+            (pieces->back().D_to + 1 == piece.D_from) &&
+            (pieces->back().Q == piece.Q) &&
+            (pieces->back().i == piece.i) && (pieces->back().j == piece.j))
+        {
+            pieces->back().D_to = piece.D_to;
+        }
+        else
+        {
+            pieces->push_back(piece);
+        }
+
+        if (last >= D_max)
+        {
+            break;
+        }
+
+        D = last + 1;
+    }
+
+}   /* sweepModelQ() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that calculates the costs that solveOptimalQ() returns
+ *         for a demand of an exact piece (see pieceAround()). The piece
+ *         gives the lowest exact CT, so only the float window of
+ *         windowOptimalQ() is left to evaluate.
+ * @param  tiers  Tiers of the reference.
+ * @param  piece  Exact piece that contains D.
+ * @param  D  Annual demand for the reference.
+ * @return Costs of the optimal order, as solveOptimalQ().
+ */
+inline solution_t pieceOptimalQ(const tiers_t * tiers,
+                                const sweep_piece_t * piece, int D)
+{
+    float ca = (tiers->ca_list[piece->i]).value;
+    float ce = (tiers->ce_list[piece->j]).value;
+    float cp = tiers->cp_percentage * ca;
+
+    METRIC_SOLVE();
+
+    return windowOptimalQ(D, tiers, modelCT(D, piece->Q, ca, ce, cp));
+
+}   /* pieceOptimalQ() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that splits [D_min, D_max] into the pieces where the
+ *         Q* of solveOptimalQ() (and its tiers) does not change: the
+ *         exact pieces of sweepModelQ(), split wherever the float Q*
+ *         of one of their demands changes.
+ * @param  tiers  Tiers of the reference.
+ * @param  D_min  First demand (at least 1).
+ * @param  D_max  Last demand (at most INT_MAX / 2).
+ * @param  pieces  Where the pieces are appended, in increasing D.
+ * @return void
+ */
+inline void sweepOptimalQ(const tiers_t * tiers, int D_min, int D_max,
+                          vector<sweep_piece_t> * pieces)
+{
+    vector<sweep_piece_t> exact;
+
+    sweepModelQ(tiers, D_min, D_max, &exact);
+
+    for (const sweep_piece_t & model : exact)
+    {
+        for (int D = model.D_from; D <= model.D_to; D++)
+        {
+            solution_t s = pieceOptimalQ(tiers, &model, D);
+
+            if ((pieces->empty() == false) &&
+                (pieces->back().D_to + 1 == D) && (pieces->back().Q == s.Q))
+            {
+                pieces->back().D_to = D;
+                continue;
+            }
+
+            sweep_piece_t piece = { D, D, s.Q,
+                                    findTier(tiers->ca_list, tiers->ca_count,
+                                             s.Q),
+                                    findTier(tiers->ce_list, tiers->ce_count,
+                                             s.Q) };
+
+            pieces->push_back(piece);
+        }
+    }
+
+}   /* sweepOptimalQ() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that calculates the costs of a demand of a piece. CT
+ *         is linear in D inside a piece, so the whole curve can be
+ *         drawn from its ends.
+ * @param  tiers  Tiers of the reference.
+ * @param  piece  Piece that contains D.
+ * @param  D  Annual demand for the reference.
+ * @return Costs of ordering the Q* of the piece.
+ */
+inline solution_t pieceSolution(const tiers_t * tiers,
+                                const sweep_piece_t * piece, int D)
+{
+    return evaluateQ(D, piece->Q, (tiers->ca_list[piece->i]).value,
+                     (tiers->ce_list[piece->j]).value, tiers->cp_percentage);
+
+}   /* pieceSolution() */
+
+#endif /* SWEEP_H */
+
+/*** end of file ***/
@@ -0,0 +1,46 @@
+#!/bin/sh
+#
+# @file     static_export_test.sh
+#
+# @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+# @date     November, 2024
+# @section  LIO-GIIROB
+# @brief    Test of static_catalog.h: a catalog of a few thousand
+#           references (the ones of catalog.csv, repeated with other IDs)
+#           is written with --export-static and the program is built
+#           with it (-DEOQ_STATIC_CATALOG). The static build must compile
+#           and solve every reference as the text catalog does.
+#
+#           sh tests/static_export_test.sh [references]
+
+set -e
+
+count=${1:-3000}
+here=$(cd "$(dirname "$0")/.." && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+cp "$here"/*.h "$here"/optimalQ.cpp "$work"
+
+grep -v '^#' "$here/catalog.csv" | awk -F';' -v count="$count" '
+    NF == 5 { sub(/^[^;]*/, ""); rest[n++] = $0 }
+    END { for (i = 0; i < count; i++) print "REF" i rest[i % n] }' \
+    > "$work/catalog.csv"
+
+awk -F';' '{ print $1 ";" 1 + NR * 37 % 50000 }' "$work/catalog.csv" \
+    > "$work/rows.csv"
+
+g++ -O2 -pthread "$work/optimalQ.cpp" -o "$work/optimalQ"
+"$work/optimalQ" --catalog "$work/catalog.csv" \
+    --export-static "$work/catalog_static.h"
+"$work/optimalQ" --catalog "$work/catalog.csv" --batch \
+    < "$work/rows.csv" > "$work/text.csv"
+
+g++ -O2 -pthread -DEOQ_STATIC_CATALOG "$work/optimalQ.cpp" \
+    -o "$work/optimalQ_static"
+"$work/optimalQ_static" --batch < "$work/rows.csv" > "$work/static.csv"
+
+cmp "$work/text.csv" "$work/static.csv"
+echo "$count referencias: la versión estática da la misma salida"
+
+### end of file ###
@@ -0,0 +1,167 @@
+/**
+ * @file     stream_test.cpp
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Test of stream.h: random references receive random daily
+ *           consumptions (with returns and gaps longer than the window),
+ *           and at the end the last Q* that the stream reported for each
+ *           reference, and the costs it keeps for the final D, must be
+ *           the solveOptimalQ() of that D, as the batch mode gives.
+ *
+ *           g++ -O2 -Wall -Wextra tests/stream_test.cpp -o stream_test
+ *           ./stream_test [seed]
+ */
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "../stream.h"
+
+#include <random>
+#include <stdio.h>
+
+using namespace std;
+
+//-----[ CONSTANTS ]----------------------------------------------------------//
+
+#define TEST_ITEMS 300
+#define TEST_EVENTS 200000
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that makes random tiers: breakpoints that grow, prices
+ *         that fall with the quantity and issue costs in any order.
+ * @param  rng  Random generator.
+ * @param  list  Where the tiers are written.
+ * @param  low  Lowest value of a tier.
+ * @param  high  Highest value of a tier.
+ * @param  falling  true if each tier is cheaper than the previous one.
+ * @return void
+ */
+static void randomTiers(mt19937_64 & rng, vector<cost_t> * list,
+                        float low, float high, bool falling)
+{
+    int count = 1 + (int)(rng() % 5);
+    int min_unit = 1;
+    float value = low + (high - low) * (float)(rng() % 1000) / 1000.0f;
+
+    list->clear();
+
+    for (int k = 0; k < count; k++)
+    {
+        list->push_back({ min_unit, value });
+
+        min_unit += 1 + (int)(rng() % 2000);
+        value = falling ? value * (0.5f + (float)(rng() % 500) / 1000.0f)
+                        : low + (high - low) * (float)(rng() % 1000) / 1000.0f;
+    }
+
+}   /* randomTiers() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that tells if two solutions are the same, bit to bit.
+ * @param  a  First solution.
+ * @param  b  Second solution.
+ * @return true if every field is equal.
+ */
+static bool sameSolution(const solution_t & a, const solution_t & b)
+{
+    return (a.Q == b.Q) && (a.ca == b.ca) && (a.ce == b.ce) &&
+           (a.cp == b.cp) && (a.CA == b.CA) && (a.CE == b.CE) &&
+           (a.CP == b.CP) && (a.CT == b.CT);
+
+}   /* sameSolution() */
+
+/******************************************************************************/
+/*!
+ * @brief  Main function of the test.
+ * @param  argc  Number of command line arguments.
+ * @param  argv  Command line arguments (the seed, 1 by default).
+ * @return 0 if the stream agrees with solveOptimalQ(), 1 otherwise.
+ */
+int main(int argc, char * argv[])
+{
+    uint64_t seed = (argc > 1) ? strtoull(argv[1], NULL, 10) : 1;
+    mt19937_64 rng(seed);
+    vector<reference_t> items(TEST_ITEMS);
+    vector<int> reported(TEST_ITEMS, 0);
+    stream_t stream;
+    int64_t day = 19000;
+    int errors = 0;
+
+    initStream(&stream);
+
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        reference_t & item = items[i];
+
+        randomTiers(rng, &(item.ca_list), 0.05f, 200.0f, true);
+        randomTiers(rng, &(item.ce_list), 1.0f, 80.0f, false);
+        item.cp_percentage = 0.05f + (float)(rng() % 300) / 1000.0f;
+
+        tiers_t tiers = tiersOf(&item);
+
+        addStreamItem(&stream, to_string(i), &tiers);
+    }
+
+    // The last Q* printed for each reference, as runStream() does
+    auto changed = [&](size_t i)
+    {
+        reported[i] = stream.items[i].best.Q;
+    };
+
+    for (int e = 0; e < TEST_EVENTS; e++)
+    {
+        size_t i = rng() % items.size();
+        int64_t units = (int64_t)(rng() % 400);
+
+        if (rng() % 20 == 0)
+        {
+            units = -units / 4;                 // A return
+        }
+
+        if (rng() % 500 == 0)
+        {
+            day += 1 + (int64_t)(rng() % 500);  // Maybe a whole window
+        }
+        else if (rng() % 50 == 0)
+        {
+            day++;
+        }
+
+        addStreamEvent(&stream, i, day, units, changed);
+    }
+
+    for (size_t i = 0; i < stream.items.size(); i++)
+    {
+        const stream_item_t & item = stream.items[i];
+        int D = (item.D > 0) ? (int)item.D : 0;
+        solution_t batch = solveOptimalQ(D, &(item.tiers));
+
+        if (reported[i] != batch.Q)
+        {
+            printf("%zu: D=%d, el stream dio Q=%d y solveOptimalQ Q=%d\n",
+                   i, D, reported[i], batch.Q);
+            errors++;
+        }
+        else if ((batch.Q > 0) && !sameSolution(item.best, batch))
+        {
+            printf("%zu: D=%d, los costes guardados no son los de "
+                   "solveOptimalQ\n", i, D);
+            errors++;
+        }
+    }
+
+    printf("%zu referencias, %llu eventos, %llu resoluciones: %d errores\n",
+           stream.items.size(), (unsigned long long)stream.events,
+           (unsigned long long)stream.solves, errors);
+
+    return (errors == 0) ? 0 : 1;
+
+}   /* main() */
+
+/*** end of file ***/
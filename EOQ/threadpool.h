@@ -0,0 +1,174 @@
+/**
+ * @file     threadpool.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Work-stealing parallel loop used to spread many independent
+ *           solves over several threads.
+ *
+ *           Every thread starts with a contiguous slice of the indices
+ *           and takes small chunks from the front of it. A thread that
+ *           runs out of work steals the back half of the slice of
+ *           another thread, so references with many tiers (slow) do not
+ *           leave the rest of the threads waiting.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef struct
+{
+    mutex lock;
+    size_t begin;   // Next index of the slice
+    size_t end;     // One past the last index of the slice
+
+} work_slice_t;
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that gets the number of threads to use by default.
+ * @param  void
+ * @return Number of hardware threads (at least 1).
+ */
+inline int defaultThreads(void)
+{
+    return max(1, (int)thread::hardware_concurrency());
+
+}   /* defaultThreads() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that takes the next chunk of a slice, or steals the
+ *         back half of the slice of another thread when it is empty.
+ * @param  slices  Slices of every thread.
+ * @param  self  Thread that asks for work.
+ * @param  grain  Number of indices of each chunk.
+ * @param  begin  Where the first index of the chunk is stored.
+ * @param  end  Where one past the last index of the chunk is stored.
+ * @return false if there is no work left anywhere.
+ */
+inline bool nextChunk(vector<work_slice_t> & slices, size_t self,
+                      size_t grain, size_t * begin, size_t * end)
+{
+    for (size_t k = 0; k < slices.size(); k++)
+    {
+        // The first try is the own slice, then the others in order
+        work_slice_t & victim = slices[(self + k) % slices.size()];
+        size_t stolenBegin, stolenEnd;
+
+        {
+            lock_guard<mutex> guard(victim.lock);
+
+            if (victim.begin >= victim.end)
+            {
+                continue;
+            }
+
+            if (k == 0)
+            {
+                *begin = victim.begin;
+                *end = min(victim.begin + grain, victim.end);
+                victim.begin = *end;
+                return true;
+            }
+
+            // Steal the back half of the slice
+            stolenBegin = victim.begin + (victim.end - victim.begin) / 2;
+            stolenEnd = victim.end;
+            victim.end = stolenBegin;
+        }
+
+        // Run its first chunk and keep the rest as the own slice
+        *begin = stolenBegin;
+        *end = min(stolenBegin + grain, stolenEnd);
+
+        lock_guard<mutex> guard(slices[self].lock);
+        slices[self].begin = *end;
+        slices[self].end = stolenEnd;
+        return true;
+    }
+
+    return false;
+
+}   /* nextChunk() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that calls body(begin, end) over chunks that cover
+ *         [0, count) exactly once, using a work-stealing set of threads.
+ *         It returns when every chunk is done. The body must only write
+ *         to its own indices, so the results do not depend on which
+ *         thread ran each chunk.
+ * @param  count  Number of indices.
+ * @param  threads  Number of threads (1 runs everything in the caller).
+ * @param  grain  Number of indices of each chunk.
+ * @param  body  Work to do over [begin, end).
+ * @return void
+ */
+inline void parallelFor(size_t count, int threads, size_t grain,
+                        const function<void(size_t, size_t)> & body)
+{
+    if (grain == 0)
+    {
+        grain = 1;
+    }
+
+    if ((threads <= 1) || (count <= grain))
+    {
+        body(0, count);
+        return;
+    }
+
+    vector<work_slice_t> slices(threads);
+
+    for (int t = 0; t < threads; t++)
+    {
+        slices[t].begin = count * t / threads;
+        slices[t].end = count * (t + 1) / threads;
+    }
+
+    auto worker = [&](size_t self)
+    {
+        size_t begin, end;
+
+        while (nextChunk(slices, self, grain, &begin, &end))
+        {
+            body(begin, end);
+        }
+    };
+
+    vector<thread> pool;
+
+    for (int t = 1; t < threads; t++)
+    {
+        pool.push_back(thread(worker, t));
+    }
+
+    // The calling thread is worker 0
+    worker(0);
+
+    for (size_t t = 0; t < pool.size(); t++)
+    {
+        pool[t].join();
+    }
+
+}   /* parallelFor() */
+
+#endif /* THREADPOOL_H */
+
+/*** end of file ***/
@@ -0,0 +1,72 @@
+/**
+ * @file     tiers.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Lookup of the active tier of a ca_list or ce_list for any
+ *           quantity. The lists are already sorted by min_unit (the
+ *           catalog loader checks it), so a branch-free binary search
+ *           over the contiguous cost_t array finds the tier in
+ *           O(log tiers) and never reads past the end of the list.
+ */
+
+#ifndef TIERS_H
+#define TIERS_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include "types.h"
+#include "metrics.h"
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that finds the tier that applies to Q units, that is,
+ *         the last one whose min_unit is not greater than Q. The loop
+ *         always runs log2(count) times and the comparison becomes a
+ *         conditional move, so there are no mispredicted branches.
+ * @param  list  Tiers sorted by min_unit.
+ * @param  count  Number of tiers (at least 1).
+ * @param  Q  Units of the order.
+ * @return Index of the tier (0 if Q is below every min_unit).
+ */
+inline int findTier(const cost_t * list, int count, int Q)
+{
+    const cost_t * base = list;
+    int n = count;
+
+    METRIC_ADD(probes, 1);
+
+    while (n > 1)
+    {
+        int half = n / 2;
+
+        base = ((base[half]).min_unit <= Q) ? (base + half) : base;
+        n -= half;
+    }
+
+    return (int)(base - list);
+
+}   /* findTier() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that gets the ca and ce prices that apply to Q units.
+ * @param  tiers  Tiers of the reference.
+ * @param  Q  Units of the order.
+ * @param  ca  Where the Acquisition Cost per unit is stored.
+ * @param  ce  Where the Cost of Issue per order is stored.
+ * @return void
+ */
+inline void tierPrices(const tiers_t * tiers, int Q, float * ca, float * ce)
+{
+    *ca = (tiers->ca_list[findTier(tiers->ca_list, tiers->ca_count, Q)]).value;
+    *ce = (tiers->ce_list[findTier(tiers->ce_list, tiers->ce_count, Q)]).value;
+
+}   /* tierPrices() */
+
+#endif /* TIERS_H */
+
+/*** end of file ***/
@@ -0,0 +1,136 @@
+/**
+ * @file     types.h
+ *
+ * @author   Marcos Belda Martinez' <mbelmar@etsinf.upv.es>
+ * @date     November, 2024
+ * @section  LIO-GIIROB
+ * @brief    Definition of the types that describe a reference, shared by
+ *           references.h, the catalog loader and the solver.
+ */
+
+#ifndef TYPES_H
+#define TYPES_H
+
+//-----[ INCLUDES ]-----------------------------------------------------------//
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//-----[ TYPEDEF STRUCTS ]----------------------------------------------------//
+
+typedef enum
+{
+    PRICING_ALL_UNITS,      // The ca of the tier of Q for every unit
+    PRICING_INCREMENTAL     // Each unit at the ca of its own tier
+
+} pricing_t;
+
+typedef enum
+{
+    ISSUE_TIERED,           // The ce of the tier of Q per order
+    ISSUE_FREIGHT           // That ce plus a freight per unit ordered
+
+} issue_t;
+
+typedef enum
+{
+    HOLDING_PERCENTAGE,     // cp_percentage of the price paid per unit
+    HOLDING_ABSOLUTE        // A fixed cost per unit and year
+
+} holding_t;
+
+typedef struct
+{
+    pricing_t pricing;
+    issue_t issue;
+    holding_t holding;
+    float freight;          // Per unit ordered (ISSUE_FREIGHT)
+    float holding_cost;     // Per unit and year (HOLDING_ABSOLUTE)
+
+} cost_model_t;
+
+typedef struct
+{
+    int min_unit;
+    float value;
+    
+} cost_t;
+
+typedef struct
+{
+    string supplier;
+    vector<cost_t> ca_list;
+    vector<cost_t> ce_list;     // With the shipping of each order added
+    float shipping;             // Shipping cost of each order
+
+} offer_t;
+
+typedef struct
+{
+    string id;
+    string description;
+    vector<cost_t> ca_list;
+    vector<cost_t> ce_list;
+    float cp_percentage;
+    vector<offer_t> offers;     // Other suppliers (see suppliers.h)
+    cost_model_t model;         // Cost model (see policy.h)
+
+} reference_t;
+
+typedef struct
+{
+    const cost_t * ca_list;     // Acquisition Cost tiers
+    int ca_count;
+    const cost_t * ce_list;     // Cost of Issue tiers
+    int ce_count;
+    float cp_percentage;
+    const cost_model_t * model; // NULL for the original model
+
+} tiers_t;
+
+//-----[ IMPLEMENTATION OF THE FUNCTIONS ]------------------------------------//
+
+/******************************************************************************/
+/*!
+ * @brief  Method that gets the tiers of a reference as a view that
+ *         the solver can use without knowing where they are stored.
+ * @param  item  Pointer to reference.
+ * @return View of the tiers (valid while the reference is alive).
+ */
+inline tiers_t tiersOf(const reference_t * item)
+{
+    tiers_t tiers;
+
+    tiers.ca_list = (item->ca_list).data();
+    tiers.ca_count = (int)(item->ca_list).size();
+    tiers.ce_list = (item->ce_list).data();
+    tiers.ce_count = (int)(item->ce_list).size();
+    tiers.cp_percentage = item->cp_percentage;
+    tiers.model = &(item->model);
+
+    return tiers;
+
+}   /* tiersOf() */
+
+/******************************************************************************/
+/*!
+ * @brief  Method that tells whether a cost model is the one of the
+ *         original program: all-units ca, ce per order and cp as a
+ *         percentage of ca.
+ * @param  model  Cost model, or NULL.
+ * @return true if it is the original model.
+ */
+inline bool originalModel(const cost_model_t * model)
+{
+    return (model == NULL) ||
+           ((model->pricing == PRICING_ALL_UNITS) &&
+            (model->issue == ISSUE_TIERED) &&
+            (model->holding == HOLDING_PERCENTAGE));
+
+}   /* originalModel() */
+
+#endif /* TYPES_H */
+
+/*** end of file ***/